@@ -0,0 +1,41 @@
+#include <cstdio>
+#include <cstdlib>
+#include <iostream>
+
+#include <parser.hpp>
+#include <solver.hpp>
+#include <batch.hpp>
+
+int main(int argc, char* argv[]) {
+  if (argc < 2) {
+    BatchArguments::print_usage();
+    exit(1);
+  }
+
+  BatchArguments args(argc, argv);
+
+  double budget = static_cast<double>(args.get_memory_budget()) * (1 << 20);
+  if (budget == 0.0) {
+    budget = 0.8 * available_memory_bytes();
+  }
+  if (budget <= 0.0) {
+    fmt::print("Could not determine the available memory, set --memory-budget\n");
+    exit(1);
+  }
+
+  auto jobs = read_jobs(args.get_jobs_file());
+  if (jobs.empty()) {
+    fmt::print("No jobs in {}\n", args.get_jobs_file());
+    exit(1);
+  }
+
+  auto executor = batch_executor(args, budget);
+  for (auto &job : jobs) {
+    executor.prepare(*job);
+  }
+  if (executor.run(jobs) > 0) {
+    return 1;
+  }
+
+  return 0;
+}
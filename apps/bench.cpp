@@ -0,0 +1,61 @@
+#include <cstdio>
+#include <cstdlib>
+#include <iostream>
+
+#include <parser.hpp>
+#include <solver.hpp>
+#include <bench.hpp>
+#include <regression.hpp>
+
+int main(int argc, char* argv[]) {
+  BenchArguments args(argc, argv);
+
+  auto config = solver_config{};
+  config.timeout = args.get_timeout();
+  config.algorithm = args.get_algorithm();
+  auto solve = [&](const instance_file &instance, progress_counters &counters) {
+    config.counters = &counters;
+    return solve_mobkp(config, instance.n, instance.m, instance.k, instance.points, instance.multiplicities).second;
+  };
+
+  // With a baseline the same instances are run again, otherwise they are discovered.
+  std::vector<bench_result> baseline;
+  std::vector<bench_instance> instances;
+  if (!args.get_baseline().empty()) {
+    baseline = load_baseline(args.get_baseline());
+    for (auto const &r : baseline) {
+      instances.push_back(r.instance);
+    }
+  } else {
+    instances = discover_instances(args);
+  }
+  if (instances.empty()) {
+    fmt::print("No instances found in {}\n", args.get_instances_dir());
+    exit(1);
+  }
+
+  std::vector<bench_result> results;
+  for (auto const &instance : instances) {
+    results.push_back(run_instance(args, instance, solve));
+    auto const &r = results.back();
+    auto sorted = r.times;
+    std::sort(sorted.begin(), sorted.end());
+    fmt::print("{} median={:.6f}s p90={:.6f}s rss={}KiB states={}/{} front={}/{} {}\n", instance.path,
+               percentile(sorted, 50), percentile(sorted, 90), r.peak_rss_kb, r.peak_states, r.total_states, r.front_size,
+               r.expected_front_size, r.front_ok ? "ok" : "MISMATCH");
+  }
+  write_json(args.get_outfile(), args, results);
+
+  if (!baseline.empty()) {
+    auto regression = regression_config{};
+    regression.threshold = args.get_threshold();
+    regression.memory_threshold = args.get_memory_threshold();
+    regression.confidence = args.get_confidence();
+    regression.resamples = args.get_resamples();
+    if (compare_results(baseline, results, regression) > 0) {
+      return 2;
+    }
+  }
+
+  return 0;
+}
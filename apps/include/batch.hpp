@@ -0,0 +1,326 @@
+#ifndef BATCH_HPP
+#define BATCH_HPP
+
+#include <fmt/core.h>
+
+#include <algorithm>
+#include <chrono>
+#include <cmath>
+#include <condition_variable>
+#include <fstream>
+#include <iostream>
+#include <memory>
+#include <mutex>
+#include <stdexcept>
+#include <string>
+#include <thread>
+#include <vector>
+
+#include <numa.hpp>
+#include <parser.hpp>
+#include <solver.hpp>
+
+class BatchArguments {
+ public:
+  BatchArguments(int argc, char **argv) : argc(argc), argv(argv) {
+    jobs = std::max(1u, std::thread::hardware_concurrency());
+    memory_budget = 0;
+    estimate_budget = 0.2;
+    headroom = 1.25;
+    numa = "on";
+    parse_arguments(argv);
+    validate_arguments();
+  }
+
+  static void print_usage() {
+    std::cout << "Usage: [options]\n"
+              << "--jobs-file=<filename>  File with one mobkp-instances command line (its options) per job\n"
+              << "--jobs=<number>         Maximum number of concurrent solves\n"
+              << "--memory-budget=<MiB>   Memory shared by the concurrent solves\n"
+              << "--estimate-budget=<number> Seconds spent estimating the memory of each job before queuing it\n"
+              << "--headroom=<number>     Factor applied to the memory projections of running jobs\n"
+              << "--numa=<on|off>         Run each job on one NUMA node with node-local memory\n"
+              << "Default values: jobs=hardware threads, memory-budget=80% of the available memory,\n"
+              << "                estimate-budget=0.2, headroom=1.25, numa=on\n";
+  }
+
+  std::string get_jobs_file() const { return jobs_file; }
+  int32_t get_jobs() const { return jobs; }
+  int64_t get_memory_budget() const { return memory_budget; }
+  double get_estimate_budget() const { return estimate_budget; }
+  double get_headroom() const { return headroom; }
+  bool get_numa() const { return numa == "on"; }
+
+ private:
+  int argc;
+  char **argv;
+  std::string jobs_file;
+  int32_t jobs;
+  int64_t memory_budget;
+  double estimate_budget;
+  double headroom;
+  std::string numa;
+
+  void parse_arguments(char **argv) {
+    for (int i = 1; i < argc; ++i) {
+      std::string arg = argv[i];
+      size_t pos = arg.find('=');
+      std::string key = arg.substr(0, pos);
+      std::string value = (pos != std::string::npos) ? arg.substr(pos + 1) : "";
+
+      if (key == "--jobs-file") {
+        jobs_file = value;
+      } else if (key == "--jobs") {
+        jobs = std::stoi(value);
+      } else if (key == "--memory-budget") {
+        memory_budget = std::stoll(value);
+      } else if (key == "--estimate-budget") {
+        estimate_budget = std::stod(value);
+      } else if (key == "--headroom") {
+        headroom = std::stod(value);
+      } else if (key == "--numa") {
+        numa = value;
+      } else {
+        print_usage();
+        throw std::invalid_argument("Unknown argument: " + key);
+      }
+    }
+  }
+
+  void validate_arguments() {
+    if (jobs_file.empty()) {
+      throw std::invalid_argument("A jobs file is required.");
+    }
+    if (jobs <= 0) {
+      throw std::invalid_argument("Jobs must be greater than 0.");
+    }
+    if (memory_budget < 0) {
+      throw std::invalid_argument("Memory budget must be non-negative.");
+    }
+    if (estimate_budget <= 0.0) {
+      throw std::invalid_argument("Estimate budget must be greater than 0.0.");
+    }
+    if (headroom < 1.0) {
+      throw std::invalid_argument("Headroom must be at least 1.0.");
+    }
+    if (numa != "on" && numa != "off") {
+      throw std::invalid_argument("Invalid numa value. Must be on or off.");
+    }
+  }
+};
+
+// MemAvailable of /proc/meminfo in bytes, 0 when unknown.
+int64_t available_memory_bytes() {
+  auto meminfo = std::ifstream("/proc/meminfo");
+  std::string key;
+  int64_t value = 0;
+  std::string unit;
+  while (meminfo >> key >> value >> unit) {
+    if (key == "MemAvailable:") {
+      return value * 1024;
+    }
+  }
+  return 0;
+}
+
+struct batch_job {
+  size_t id = 0;
+  std::string line;
+  std::unique_ptr<Arguments> args;
+  std::vector<data_type> points;
+  double state_bytes = 0.0;  // bytes of one state of the native engines
+  double estimate = 0.0;     // predicted peak memory, upper bound
+  double reservation = 0.0;  // memory currently held in the budget
+  bool fixed = false;        // the reservation does not follow the state counts
+  size_t node = 0;           // NUMA node the job runs on
+  progress_counters counters;
+  std::thread thread;
+  bool finished = false;
+  std::string error;
+};
+
+std::vector<std::unique_ptr<batch_job>> read_jobs(const std::string &file_path) {
+  auto in = std::ifstream(file_path);
+  if (!in.is_open()) {
+    throw std::runtime_error("Could not open file " + file_path);
+  }
+  std::vector<std::unique_ptr<batch_job>> jobs;
+  std::string line;
+  while (std::getline(in, line)) {
+    if (line.find_first_not_of(" \t") == std::string::npos || line[line.find_first_not_of(" \t")] == '#') {
+      continue;
+    }
+    auto job = std::make_unique<batch_job>();
+    job->id = jobs.size();
+    job->line = line;
+    job->args = parse_arguments_line(line);
+    jobs.push_back(std::move(job));
+  }
+  return jobs;
+}
+
+// Runs the jobs concurrently within a global memory budget.
+//
+// Every job reserves its estimated peak memory before it starts. Jobs are
+// admitted in order, skipping those that do not fit, so small jobs fill the
+// gaps left by large ones; a job larger than the whole budget only runs
+// alone. While a native engine runs, its reservation follows the published
+// state counts: it grows as soon as the next layer is projected to exceed it
+// and shrinks once half of the layers are done and the projected peak is lower.
+//
+// On a NUMA machine each job is placed on the node with the least reserved
+// memory and its thread is bound to that node, so its states stay local.
+class batch_executor {
+ public:
+  batch_executor(const BatchArguments &args, double budget) : args(args), budget(budget) {
+    if (args.get_numa()) {
+      nodes = numa_nodes();
+    }
+    node_reserved.resize(std::max<size_t>(1, nodes.size()), 0.0);
+  }
+
+  // Generates the points of every job and estimates its memory.
+  void prepare(batch_job &job) {
+    auto const &a = *job.args;
+    job.points = generate_points(a);
+    const auto config = solver_config::from_arguments(a);
+    if (a.get_m() >= 3 && !config.external_dir.empty()) {
+      // The external-memory DP keeps to its own budget.
+      job.estimate = static_cast<double>(config.external_memory) * (1 << 20);
+      job.fixed = true;
+    } else {
+      const auto estimate = estimate_solve(a, job.points, args.get_estimate_budget());
+      job.estimate = estimate.memory_bytes.high;
+      job.fixed = config.algorithm == "mobkp" && a.get_k() == 1;
+    }
+    job.state_bytes = 3.0 * (a.get_m() + a.get_k()) * sizeof(data_type);
+    fmt::print("job {}: estimated {:.1f} MiB{} ({})\n", job.id, job.estimate / (1 << 20), job.fixed ? " fixed" : "",
+               job.line);
+  }
+
+  // Returns the number of failed jobs.
+  size_t run(std::vector<std::unique_ptr<batch_job>> &jobs) {
+    std::vector<batch_job *> pending;
+    for (auto &job : jobs) {
+      pending.push_back(job.get());
+    }
+    std::unique_lock<std::mutex> lock(mutex);
+    while (!pending.empty() || running > 0) {
+      admit(pending);
+      cv.wait_for(lock, std::chrono::milliseconds(100));
+      adjust(jobs);
+    }
+    size_t failed = 0;
+    for (auto &job : jobs) {
+      if (job->thread.joinable()) {
+        job->thread.join();
+      }
+      failed += !job->error.empty();
+    }
+    fmt::print("batch: {} jobs, {} failed, peak reservation {:.1f} MiB of {:.1f} MiB\n", jobs.size(), failed,
+               peak_reserved / (1 << 20), budget / (1 << 20));
+    return failed;
+  }
+
+ private:
+  const BatchArguments &args;
+  double budget;
+  double reserved = 0.0;
+  double peak_reserved = 0.0;
+  size_t running = 0;
+  std::vector<numa_node> nodes;
+  std::vector<double> node_reserved;
+  std::mutex mutex;
+  std::condition_variable cv;
+
+  void reserve(batch_job &job, double bytes) {
+    reserved += bytes - job.reservation;
+    node_reserved[job.node] += bytes - job.reservation;
+    job.reservation = bytes;
+    peak_reserved = std::max(peak_reserved, reserved);
+  }
+
+  // Starts the pending jobs that fit, in order. Called with the lock held.
+  void admit(std::vector<batch_job *> &pending) {
+    for (auto it = pending.begin(); it != pending.end() && running < static_cast<size_t>(args.get_jobs());) {
+      batch_job &job = **it;
+      if (reserved + job.estimate > budget && running > 0) {
+        ++it;
+        continue;
+      }
+      if (job.estimate > budget) {
+        fmt::print("job {}: estimated memory exceeds the budget, running alone\n", job.id);
+      }
+      job.node = std::min_element(node_reserved.begin(), node_reserved.end()) - node_reserved.begin();
+      reserve(job, job.estimate);
+      ++running;
+      fmt::print("job {}: started{}, reserved {:.1f} of {:.1f} MiB\n", job.id,
+                 nodes.size() > 1 ? fmt::format(" on node {}", nodes[job.node].id) : "", reserved / (1 << 20),
+                 budget / (1 << 20));
+      job.thread = std::thread([this, &job]() {
+        if (nodes.size() > 1 && !bind_thread_to_node(nodes[job.node])) {
+          fmt::print(stderr, "job {}: could not bind to node {}\n", job.id, nodes[job.node].id);
+        }
+        execute(job);
+      });
+      it = pending.erase(it);
+    }
+  }
+
+  void execute(batch_job &job) {
+    const auto start = std::chrono::steady_clock::now();
+    size_t front_size = 0;
+    try {
+      auto const &a = *job.args;
+      auto config = solver_config::from_arguments(a);
+      config.counters = &job.counters;
+      const auto multiplicities = generate_multiplicities(a);
+      auto problem_solutions = solve_mobkp(config, a.get_n(), a.get_m(), a.get_k(), std::move(job.points), multiplicities);
+      write_solution(a.get_folder_path(), a.get_outfile(), problem_solutions.first, problem_solutions.second,
+                     multiplicities);
+      front_size = problem_solutions.second.size();
+    } catch (const std::exception &e) {
+      job.error = e.what();
+    }
+    const double seconds = std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count();
+
+    std::lock_guard<std::mutex> lock(mutex);
+    reserve(job, 0.0);
+    job.finished = true;
+    --running;
+    if (job.error.empty()) {
+      fmt::print("job {}: done in {:.3f}s, front={}\n", job.id, seconds, front_size);
+    } else {
+      fmt::print("job {}: failed: {}\n", job.id, job.error);
+    }
+    cv.notify_all();
+  }
+
+  // Moves the reservations of the running native solves towards their
+  // projected memory. Called with the lock held.
+  void adjust(std::vector<std::unique_ptr<batch_job>> &jobs) {
+    for (auto &p : jobs) {
+      batch_job &job = *p;
+      const size_t done = job.counters.layers_done.load(std::memory_order_relaxed);
+      if (!job.thread.joinable() || job.finished || job.fixed || done == 0) {
+        continue;
+      }
+      const size_t items = job.counters.items.load(std::memory_order_relaxed);
+      const double states = static_cast<double>(job.counters.states.load(std::memory_order_relaxed));
+      const size_t previous = job.counters.previous_states.load(std::memory_order_relaxed);
+      const double growth = previous > 0 ? std::max(1.0, states / previous) : 1.0;
+      const double next = states * growth * job.state_bytes * args.get_headroom();
+      if (next > job.reservation) {
+        reserve(job, next);
+      } else if (2 * done >= items) {
+        const double remaining = static_cast<double>(items - std::min(done, items));
+        const double peak = states * std::pow(growth, remaining) * job.state_bytes * args.get_headroom();
+        if (peak < job.reservation) {
+          reserve(job, std::max(peak, next));
+        }
+      }
+    }
+  }
+};
+
+#endif  // BATCH_HPP
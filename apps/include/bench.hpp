@@ -0,0 +1,352 @@
+#ifndef BENCH_HPP
+#define BENCH_HPP
+
+#include <fmt/core.h>
+#include <fmt/ostream.h>
+#include <fmt/ranges.h>
+
+#include <algorithm>
+#include <chrono>
+#include <cmath>
+#include <filesystem>
+#include <fstream>
+#include <iostream>
+#include <limits>
+#include <numeric>
+#include <set>
+#include <sstream>
+#include <stdexcept>
+#include <string>
+#include <tuple>
+#include <vector>
+
+#include <instance.hpp>
+#include <progress.hpp>
+
+class BenchArguments {
+ public:
+  BenchArguments(int argc, char **argv) : argc(argc), argv(argv) {
+    instances_dir = "../instances/";
+    types = {0, 1, 2};
+    n_min = 0;
+    n_max = std::numeric_limits<int32_t>::max();
+    warmup = 1;
+    repetitions = 5;
+    timeout = 3600.0;
+    outfile = "bench.json";
+    threshold = 0.05;
+    memory_threshold = 0.10;
+    confidence = 0.95;
+    resamples = 2000;
+    algorithm = "mobkp";
+    parse_arguments(argv);
+    validate_arguments();
+  }
+
+  static void print_usage() {
+    std::cout << "Usage: [options]\n"
+              << "--instances=<path>      Instance library directory\n"
+              << "--type=<list>           Comma separated instance types (0: random, 1: negative correlation, 2: positive correlation, 3: bounded)\n"
+              << "--m=<list>              Comma separated number of objectives\n"
+              << "--n-min=<number>        Smallest number of items\n"
+              << "--n-max=<number>        Largest number of items\n"
+              << "--warmup=<number>       Untimed solves before measuring each instance\n"
+              << "--repetitions=<number>  Timed solves of each instance\n"
+              << "--timeout=<number>      Timeout value in seconds of each solve\n"
+              << "--outfile=<filename>    JSON file with the results\n"
+              << "--baseline=<filename>   JSON file of a previous run to compare against, runs the same instances\n"
+              << "--threshold=<number>    Relative slowdown tolerated before flagging a regression\n"
+              << "--memory-threshold=<number> Relative peak RSS growth tolerated before flagging a regression\n"
+              << "--confidence=<number>   Confidence level of the bootstrap intervals\n"
+              << "--resamples=<number>    Number of bootstrap resamples\n"
+              << "--algorithm=<name>      Solver engine, as in mobkp-instances (mobkp, layered, many, bnb or core)\n"
+              << "Default values: instances=../instances/, type=0,1,2, m=all, warmup=1, repetitions=5, timeout=3600,\n"
+              << "                outfile=bench.json, threshold=0.05, memory-threshold=0.10, confidence=0.95,\n"
+              << "                resamples=2000, algorithm=mobkp\n";
+  }
+
+  std::string get_instances_dir() const { return instances_dir; }
+  std::vector<int32_t> get_types() const { return types; }
+  std::vector<int32_t> get_ms() const { return ms; }
+  int32_t get_n_min() const { return n_min; }
+  int32_t get_n_max() const { return n_max; }
+  int32_t get_warmup() const { return warmup; }
+  int32_t get_repetitions() const { return repetitions; }
+  double get_timeout() const { return timeout; }
+  std::string get_outfile() const { return outfile; }
+  std::string get_baseline() const { return baseline; }
+  double get_threshold() const { return threshold; }
+  double get_memory_threshold() const { return memory_threshold; }
+  double get_confidence() const { return confidence; }
+  int32_t get_resamples() const { return resamples; }
+  std::string get_algorithm() const { return algorithm; }
+
+ private:
+  int argc;
+  char **argv;
+  std::string instances_dir;
+  std::vector<int32_t> types;
+  std::vector<int32_t> ms;
+  int32_t n_min;
+  int32_t n_max;
+  int32_t warmup;
+  int32_t repetitions;
+  double timeout;
+  std::string outfile;
+  std::string baseline;
+  double threshold;
+  double memory_threshold;
+  double confidence;
+  int32_t resamples;
+  std::string algorithm;
+
+  static std::vector<int32_t> parse_list(const std::string &value) {
+    std::vector<int32_t> list;
+    std::stringstream ss(value);
+    std::string item;
+    while (std::getline(ss, item, ',')) {
+      list.push_back(std::stoi(item));
+    }
+    return list;
+  }
+
+  void parse_arguments(char **argv) {
+    for (int i = 1; i < argc; ++i) {
+      std::string arg = argv[i];
+      size_t pos = arg.find('=');
+      std::string key = arg.substr(0, pos);
+      std::string value = (pos != std::string::npos) ? arg.substr(pos + 1) : "";
+
+      if (key == "--instances") {
+        instances_dir = value;
+      } else if (key == "--type") {
+        types = parse_list(value);
+      } else if (key == "--m") {
+        ms = parse_list(value);
+      } else if (key == "--n-min") {
+        n_min = std::stoi(value);
+      } else if (key == "--n-max") {
+        n_max = std::stoi(value);
+      } else if (key == "--warmup") {
+        warmup = std::stoi(value);
+      } else if (key == "--repetitions") {
+        repetitions = std::stoi(value);
+      } else if (key == "--timeout") {
+        timeout = std::stod(value);
+      } else if (key == "--outfile") {
+        outfile = value;
+      } else if (key == "--baseline") {
+        baseline = value;
+      } else if (key == "--threshold") {
+        threshold = std::stod(value);
+      } else if (key == "--memory-threshold") {
+        memory_threshold = std::stod(value);
+      } else if (key == "--confidence") {
+        confidence = std::stod(value);
+      } else if (key == "--resamples") {
+        resamples = std::stoi(value);
+      } else if (key == "--algorithm") {
+        algorithm = value;
+      } else {
+        print_usage();
+        throw std::invalid_argument("Unknown argument: " + key);
+      }
+    }
+  }
+
+  void validate_arguments() {
+    for (auto type : types) {
+      if (type < 0 || type > 3) {
+        throw std::invalid_argument("Invalid type value. Must be between 0 and 3.");
+      }
+    }
+    for (auto m : ms) {
+      if (m <= 1) {
+        throw std::invalid_argument("m must be greater than 1.");
+      }
+    }
+    if (n_min > n_max) {
+      throw std::invalid_argument("n-min must not be greater than n-max.");
+    }
+    if (warmup < 0) {
+      throw std::invalid_argument("Warmup must be non-negative.");
+    }
+    if (repetitions <= 0) {
+      throw std::invalid_argument("Repetitions must be greater than 0.");
+    }
+    if (timeout <= 0.0) {
+      throw std::invalid_argument("Timeout must be greater than 0.0.");
+    }
+    if (threshold < 0.0 || memory_threshold < 0.0) {
+      throw std::invalid_argument("Thresholds must be non-negative.");
+    }
+    if (confidence <= 0.0 || confidence >= 1.0) {
+      throw std::invalid_argument("Confidence must be between 0.0 and 1.0.");
+    }
+    if (resamples <= 0) {
+      throw std::invalid_argument("Resamples must be greater than 0.");
+    }
+    if (algorithm != "mobkp" && algorithm != "layered" && algorithm != "many" && algorithm != "bnb" &&
+        algorithm != "core") {
+      throw std::invalid_argument("Invalid algorithm. Must be mobkp, layered, many, bnb or core.");
+    }
+  }
+};
+
+static const std::string instance_types[] = {"random", "neg_corr", "pos_corr", "bounded"};
+
+struct bench_instance {
+  std::string path;
+  int32_t type;
+  int32_t m;
+  int32_t n;
+};
+
+struct bench_result {
+  bench_instance instance;
+  std::vector<double> times;
+  size_t front_size = 0;
+  size_t expected_front_size = 0;
+  bool front_ok = false;
+  int64_t peak_rss_kb = 0;      // largest over the repetitions
+  std::vector<double> rss_kb;  // peak RSS of each repetition
+  size_t peak_states = 0;       // of the largest DP layer, 0 when the engine does not report layers
+  size_t total_states = 0;      // over all the DP layers
+};
+
+// Instances of the library matching the selection, in a stable order.
+std::vector<bench_instance> discover_instances(const BenchArguments &args) {
+  namespace fs = std::filesystem;
+  std::vector<bench_instance> instances;
+  for (auto type : args.get_types()) {
+    const fs::path type_dir = fs::path(args.get_instances_dir()) / instance_types[type];
+    if (!fs::exists(type_dir)) {
+      continue;
+    }
+    for (auto const &dim_dir : fs::directory_iterator(type_dir)) {
+      const std::string dim = dim_dir.path().filename().string();
+      if (!dim_dir.is_directory() || dim.size() < 2 || dim.back() != 'D') {
+        continue;
+      }
+      const int32_t m = std::stoi(dim.substr(0, dim.size() - 1));
+      auto ms = args.get_ms();
+      if (!ms.empty() && std::find(ms.begin(), ms.end(), m) == ms.end()) {
+        continue;
+      }
+      for (auto const &file : fs::directory_iterator(dim_dir.path())) {
+        if (file.path().extension() != ".in") {
+          continue;
+        }
+        int32_t n = 0;
+        std::ifstream(file.path()) >> n;
+        if (n >= args.get_n_min() && n <= args.get_n_max()) {
+          instances.push_back({file.path().string(), type, m, n});
+        }
+      }
+    }
+  }
+  std::sort(instances.begin(), instances.end(), [](auto const &a, auto const &b) {
+    return std::tie(a.type, a.m, a.n, a.path) < std::tie(b.type, b.m, b.n, b.path);
+  });
+  return instances;
+}
+
+// Peak resident set size of the process in KiB (VmHWM), resettable on Linux.
+int64_t peak_rss_kb() {
+  auto status = std::ifstream("/proc/self/status");
+  std::string line;
+  while (std::getline(status, line)) {
+    if (line.rfind("VmHWM:", 0) == 0) {
+      return std::stoll(line.substr(6));
+    }
+  }
+  return 0;
+}
+
+void reset_peak_rss() {
+  auto clear_refs = std::ofstream("/proc/self/clear_refs");
+  if (clear_refs.is_open()) {
+    clear_refs << "5";
+  }
+}
+
+// Nearest-rank percentile of a sorted sample, p in [0, 100].
+double percentile(const std::vector<double> &sorted, double p) {
+  if (sorted.empty()) {
+    return 0.0;
+  }
+  size_t rank = static_cast<size_t>(std::ceil(p / 100.0 * sorted.size()));
+  return sorted[std::clamp<size_t>(rank, 1, sorted.size()) - 1];
+}
+
+template <typename Solve>
+bench_result run_instance(const BenchArguments &args, const bench_instance &bi, Solve &&solve) {
+  const auto instance = read_instance(bi.path);
+  auto result = bench_result{};
+  result.instance = bi;
+  result.expected_front_size = instance.front.size();
+
+  for (int32_t r = 0; r < args.get_warmup(); ++r) {
+    auto counters = progress_counters{};
+    solve(instance, counters);
+  }
+  for (int32_t r = 0; r < args.get_repetitions(); ++r) {
+    reset_peak_rss();
+    auto counters = progress_counters{};
+    const auto start = std::chrono::steady_clock::now();
+    auto front = solve(instance, counters);
+    const auto end = std::chrono::steady_clock::now();
+    result.times.push_back(std::chrono::duration<double>(end - start).count());
+    result.rss_kb.push_back(static_cast<double>(peak_rss_kb()));
+    result.peak_rss_kb = std::max(result.peak_rss_kb, peak_rss_kb());
+    if (r == 0) {
+      auto expected = std::set<std::vector<int64_t>>(instance.front.begin(), instance.front.end());
+      auto computed = std::set<std::vector<int64_t>>(front.begin(), front.end());
+      result.front_size = front.size();
+      result.front_ok = expected == computed && computed.size() == front.size();
+      result.peak_states = counters.peak_states.load();
+      result.total_states = counters.total_states.load();
+    }
+  }
+  return result;
+}
+
+std::string json_escape(const std::string &str) {
+  std::string escaped;
+  for (char c : str) {
+    if (c == '"' || c == '\\') {
+      escaped += '\\';
+    }
+    escaped += c;
+  }
+  return escaped;
+}
+
+void write_json(const std::string &file_path, const BenchArguments &args, const std::vector<bench_result> &results) {
+  auto out = std::ofstream(file_path);
+  if (!out.is_open()) {
+    throw std::runtime_error("Could not open file " + file_path);
+  }
+  fmt::print(out, "{{\n  \"warmup\": {},\n  \"repetitions\": {},\n  \"timeout\": {},\n  \"instances\": [",
+             args.get_warmup(), args.get_repetitions(), args.get_timeout());
+  for (size_t i = 0; i < results.size(); ++i) {
+    auto const &r = results[i];
+    auto sorted = r.times;
+    std::sort(sorted.begin(), sorted.end());
+    const double mean = std::accumulate(sorted.begin(), sorted.end(), 0.0) / sorted.size();
+    fmt::print(out, "{}\n    {{\"path\": \"{}\", \"type\": \"{}\", \"m\": {}, \"n\": {},\n", i == 0 ? "" : ",",
+               json_escape(r.instance.path), instance_types[r.instance.type], r.instance.m, r.instance.n);
+    fmt::print(out, "     \"times\": [{}],\n", fmt::join(r.times, ", "));
+    fmt::print(out, "     \"rss_kb\": [{}],\n", fmt::join(r.rss_kb, ", "));
+    fmt::print(out, "     \"min\": {}, \"median\": {}, \"p90\": {}, \"max\": {}, \"mean\": {},\n", sorted.front(),
+               percentile(sorted, 50), percentile(sorted, 90), sorted.back(), mean);
+    // The library engines do not report their layers.
+    auto states = [&](size_t count) { return r.total_states > 0 ? std::to_string(count) : std::string("null"); };
+    fmt::print(out, "     \"peak_states\": {}, \"total_states\": {},\n", states(r.peak_states), states(r.total_states));
+    fmt::print(out, "     \"peak_rss_kb\": {}, \"front_size\": {}, \"expected_front_size\": {}, \"front_ok\": {}}}",
+               r.peak_rss_kb, r.front_size, r.expected_front_size, r.front_ok);
+  }
+  fmt::print(out, "\n  ]\n}}\n");
+}
+
+#endif  // BENCH_HPP
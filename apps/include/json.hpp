@@ -0,0 +1,182 @@
+#ifndef JSON_HPP
+#define JSON_HPP
+
+#include <cctype>
+#include <cstdlib>
+#include <fstream>
+#include <map>
+#include <memory>
+#include <sstream>
+#include <stdexcept>
+#include <string>
+#include <vector>
+
+// Minimal JSON reader, enough to load back the files written by the tools of
+// this repository (objects, arrays, numbers, strings, booleans and null).
+class json_value {
+ public:
+  enum class kind { null, boolean, number, string, array, object };
+
+  kind type = kind::null;
+  bool boolean = false;
+  double number = 0.0;
+  std::string string;
+  std::vector<json_value> array;
+  std::map<std::string, json_value> object;
+
+  const json_value &operator[](const std::string &key) const {
+    auto it = object.find(key);
+    if (type != kind::object || it == object.end()) {
+      throw std::runtime_error("Missing JSON key: " + key);
+    }
+    return it->second;
+  }
+
+  bool contains(const std::string &key) const { return type == kind::object && object.count(key) > 0; }
+};
+
+class json_parser {
+ public:
+  explicit json_parser(std::string text) : text(std::move(text)) {}
+
+  json_value parse() {
+    auto value = parse_value();
+    skip_whitespace();
+    if (pos != text.size()) {
+      error("trailing characters");
+    }
+    return value;
+  }
+
+ private:
+  std::string text;
+  size_t pos = 0;
+
+  [[noreturn]] void error(const std::string &what) const {
+    throw std::runtime_error("Invalid JSON at offset " + std::to_string(pos) + ": " + what);
+  }
+
+  void skip_whitespace() {
+    while (pos < text.size() && std::isspace(static_cast<unsigned char>(text[pos]))) {
+      ++pos;
+    }
+  }
+
+  void expect(char c) {
+    skip_whitespace();
+    if (pos >= text.size() || text[pos] != c) {
+      error(std::string("expected '") + c + "'");
+    }
+    ++pos;
+  }
+
+  bool consume(const std::string &word) {
+    if (text.compare(pos, word.size(), word) == 0) {
+      pos += word.size();
+      return true;
+    }
+    return false;
+  }
+
+  json_value parse_value() {
+    skip_whitespace();
+    if (pos >= text.size()) {
+      error("unexpected end");
+    }
+    json_value value;
+    const char c = text[pos];
+    if (c == '{') {
+      value.type = json_value::kind::object;
+      ++pos;
+      skip_whitespace();
+      if (pos < text.size() && text[pos] == '}') {
+        ++pos;
+        return value;
+      }
+      do {
+        skip_whitespace();
+        auto key = parse_string();
+        expect(':');
+        value.object.emplace(std::move(key), parse_value());
+        skip_whitespace();
+      } while (pos < text.size() && text[pos] == ',' && ++pos);
+      expect('}');
+    } else if (c == '[') {
+      value.type = json_value::kind::array;
+      ++pos;
+      skip_whitespace();
+      if (pos < text.size() && text[pos] == ']') {
+        ++pos;
+        return value;
+      }
+      do {
+        value.array.push_back(parse_value());
+        skip_whitespace();
+      } while (pos < text.size() && text[pos] == ',' && ++pos);
+      expect(']');
+    } else if (c == '"') {
+      value.type = json_value::kind::string;
+      value.string = parse_string();
+    } else if (consume("true")) {
+      value.type = json_value::kind::boolean;
+      value.boolean = true;
+    } else if (consume("false")) {
+      value.type = json_value::kind::boolean;
+    } else if (consume("null")) {
+      value.type = json_value::kind::null;
+    } else {
+      char *end = nullptr;
+      value.type = json_value::kind::number;
+      value.number = std::strtod(text.c_str() + pos, &end);
+      if (end == text.c_str() + pos) {
+        error("unexpected character");
+      }
+      pos = end - text.c_str();
+    }
+    return value;
+  }
+
+  std::string parse_string() {
+    if (pos >= text.size() || text[pos] != '"') {
+      error("expected string");
+    }
+    ++pos;
+    std::string str;
+    while (pos < text.size() && text[pos] != '"') {
+      if (text[pos] == '\\' && pos + 1 < text.size()) {
+        ++pos;
+        switch (text[pos]) {
+          case 'n':
+            str += '\n';
+            break;
+          case 't':
+            str += '\t';
+            break;
+          default:
+            str += text[pos];
+            break;
+        }
+      } else {
+        str += text[pos];
+      }
+      ++pos;
+    }
+    if (pos >= text.size()) {
+      error("unterminated string");
+    }
+    ++pos;
+    return str;
+  }
+};
+
+json_value read_json(const std::string &file_path) {
+  auto fin = std::ifstream(file_path);
+  if (!fin.is_open()) {
+    throw std::runtime_error("Could not open file " + file_path);
+  }
+  std::stringstream ss;
+  ss << fin.rdbuf();
+  return json_parser(ss.str()).parse();
+}
+
+#endif  // JSON_HPP
@@ -0,0 +1,169 @@
+#ifndef MICROBENCH_HPP
+#define MICROBENCH_HPP
+
+#include <fmt/core.h>
+
+#include <algorithm>
+#include <chrono>
+#include <filesystem>
+#include <fstream>
+#include <iostream>
+#include <numeric>
+#include <sstream>
+#include <stdexcept>
+#include <string>
+#include <vector>
+
+#include <instance.hpp>
+#include <layered_dp.hpp>
+#include <mobkp/problem.hpp>
+
+class MicrobenchArguments {
+ public:
+  MicrobenchArguments(int argc, char **argv) : argc(argc), argv(argv) {
+    instances_dir = "../instances/";
+    ms = {2, 3, 4};
+    sizes = {256, 1024, 4096, 16384};
+    min_time = 0.2;
+    parse_arguments(argv);
+    validate_arguments();
+  }
+
+  static void print_usage() {
+    std::cout << "Usage: [options]\n"
+              << "--instances=<path>      Instance library directory\n"
+              << "--m=<list>              Comma separated number of objectives of the random instances to sample\n"
+              << "--sizes=<list>          Comma separated state set sizes\n"
+              << "--min-time=<number>     Minimum time in seconds of each measurement\n"
+              << "Default values: instances=../instances/, m=2,3,4, sizes=256,1024,4096,16384, min-time=0.2\n";
+  }
+
+  std::string get_instances_dir() const { return instances_dir; }
+  std::vector<int32_t> get_ms() const { return ms; }
+  std::vector<int32_t> get_sizes() const { return sizes; }
+  double get_min_time() const { return min_time; }
+
+ private:
+  int argc;
+  char **argv;
+  std::string instances_dir;
+  std::vector<int32_t> ms;
+  std::vector<int32_t> sizes;
+  double min_time;
+
+  static std::vector<int32_t> parse_list(const std::string &value) {
+    std::vector<int32_t> list;
+    std::stringstream ss(value);
+    std::string item;
+    while (std::getline(ss, item, ',')) {
+      list.push_back(std::stoi(item));
+    }
+    return list;
+  }
+
+  void parse_arguments(char **argv) {
+    for (int i = 1; i < argc; ++i) {
+      std::string arg = argv[i];
+      size_t pos = arg.find('=');
+      std::string key = arg.substr(0, pos);
+      std::string value = (pos != std::string::npos) ? arg.substr(pos + 1) : "";
+
+      if (key == "--instances") {
+        instances_dir = value;
+      } else if (key == "--m") {
+        ms = parse_list(value);
+      } else if (key == "--sizes") {
+        sizes = parse_list(value);
+      } else if (key == "--min-time") {
+        min_time = std::stod(value);
+      } else {
+        print_usage();
+        throw std::invalid_argument("Unknown argument: " + key);
+      }
+    }
+  }
+
+  void validate_arguments() {
+    for (auto m : ms) {
+      if (m <= 1) {
+        throw std::invalid_argument("m must be greater than 1.");
+      }
+    }
+    for (auto size : sizes) {
+      if (size <= 0) {
+        throw std::invalid_argument("Sizes must be greater than 0.");
+      }
+    }
+    if (min_time <= 0.0) {
+      throw std::invalid_argument("Min time must be greater than 0.0.");
+    }
+  }
+};
+
+// The random instance of the library with m objectives and the most items.
+std::string largest_instance(const std::string &instances_dir, int32_t m) {
+  namespace fs = std::filesystem;
+  const fs::path dir = fs::path(instances_dir) / "random" / (std::to_string(m) + "D");
+  std::string best;
+  int32_t best_n = 0;
+  if (fs::exists(dir)) {
+    for (auto const &file : fs::directory_iterator(dir)) {
+      int32_t n = 0;
+      std::ifstream(file.path()) >> n;
+      if (file.path().extension() == ".in" && (n > best_n || (n == best_n && file.path().string() < best))) {
+        best = file.path().string();
+        best_n = n;
+      }
+    }
+  }
+  return best;
+}
+
+// A DP layer of the instance with at least `target` states (or the last layer
+// if the instance has fewer), as records of m values followed by the weight.
+// The layers are built by `extend_layer` of the layered DP, so the sets are
+// the ones the solvers work on. `items` is set to the items the layer covers.
+std::vector<int64_t> extract_layer(const instance_file &instance, size_t target, size_t &items) {
+  const size_t m = instance.m;
+  const size_t width = m + 1;
+  const auto problem = mobkp::problem<int64_t>(instance.n, m, 1, instance.points);
+  const std::vector<int64_t> capacity = {problem.weight_capacity(0)};
+  auto stats = no_stats{};
+
+  state_vector<int64_t> layer(width, 0), shifted, merged;
+  std::vector<uint8_t> from_shifted;
+  for (items = 0; items < problem.num_items() && layer.size() / width < target; ++items) {
+    extend_layer(problem, items, capacity, layer, shifted, merged, from_shifted, stats);
+  }
+  return std::vector<int64_t>(layer.begin(), layer.end());
+}
+
+// Keeps the compiler from discarding a result that is otherwise unused.
+template <typename T>
+void do_not_optimize(const T &value) {
+  asm volatile("" : : "r,m"(value) : "memory");
+}
+
+// Runs `kernel` (which performs `ops` operations per call) until `min_time`
+// has elapsed and returns the time per operation in nanoseconds.
+template <typename Kernel>
+double measure(double min_time, size_t ops, Kernel &&kernel) {
+  kernel();
+  size_t calls = 0;
+  const auto start = std::chrono::steady_clock::now();
+  double elapsed = 0.0;
+  do {
+    kernel();
+    ++calls;
+    elapsed = std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count();
+  } while (elapsed < min_time);
+  return elapsed * 1e9 / (static_cast<double>(calls) * std::max<size_t>(ops, 1));
+}
+
+void print_measurement(const std::string &kernel, int32_t m, const std::string &type, size_t size, double ns_per_op,
+                       size_t bytes_per_op) {
+  fmt::print("{:<14} m={} {:<7} size={:<7} {:>10.2f} ns/op {:>10.2f} Mop/s {:>10.2f} MB/s\n", kernel, m, type, size,
+             ns_per_op, 1e3 / ns_per_op, bytes_per_op * 1e3 / ns_per_op);
+}
+
+#endif  // MICROBENCH_HPP
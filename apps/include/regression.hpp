@@ -0,0 +1,182 @@
+#ifndef REGRESSION_HPP
+#define REGRESSION_HPP
+
+#include <fmt/core.h>
+
+#include <algorithm>
+#include <cmath>
+#include <map>
+#include <numeric>
+#include <random>
+#include <string>
+#include <vector>
+
+#include <bench.hpp>
+#include <json.hpp>
+
+// Comparison of a benchmark run against a baseline written by a previous run.
+//
+// Runtime changes are measured as the ratio of the current to the baseline
+// median, with a percentile bootstrap confidence interval obtained by
+// resampling the repetitions of both runs. An instance regresses when the whole
+// interval lies above 1 + threshold. Families (type and m) aggregate the
+// per-instance ratios by their geometric mean, bootstrapped over the
+// instances. Peak RSS is measured on each repetition and compared the same
+// way against the memory threshold; a baseline without per-repetition values
+// contributes its single peak.
+
+struct regression_config {
+  double threshold = 0.05;
+  double memory_threshold = 0.10;
+  double confidence = 0.95;
+  int32_t resamples = 2000;
+  uint64_t seed = 1;
+};
+
+struct ratio_interval {
+  double ratio = 1.0;
+  double low = 1.0;
+  double high = 1.0;
+};
+
+std::vector<bench_result> load_baseline(const std::string &file_path) {
+  const auto json = read_json(file_path);
+  std::vector<bench_result> results;
+  for (auto const &entry : json["instances"].array) {
+    auto r = bench_result{};
+    const auto type_name = entry["type"].string;
+    const auto type = std::find(std::begin(instance_types), std::end(instance_types), type_name);
+    if (type == std::end(instance_types)) {
+      throw std::runtime_error("Unknown instance type in baseline: " + type_name);
+    }
+    r.instance = {entry["path"].string, static_cast<int32_t>(type - std::begin(instance_types)),
+                  static_cast<int32_t>(entry["m"].number), static_cast<int32_t>(entry["n"].number)};
+    for (auto const &t : entry["times"].array) {
+      r.times.push_back(t.number);
+    }
+    r.peak_rss_kb = static_cast<int64_t>(entry["peak_rss_kb"].number);
+    if (entry.contains("rss_kb")) {
+      for (auto const &rss : entry["rss_kb"].array) {
+        r.rss_kb.push_back(rss.number);
+      }
+    } else {
+      r.rss_kb.push_back(static_cast<double>(r.peak_rss_kb));
+    }
+    r.front_size = static_cast<size_t>(entry["front_size"].number);
+    r.expected_front_size = static_cast<size_t>(entry["expected_front_size"].number);
+    r.front_ok = entry["front_ok"].boolean;
+    if (entry.contains("total_states") && entry["total_states"].type == json_value::kind::number) {
+      r.peak_states = static_cast<size_t>(entry["peak_states"].number);
+      r.total_states = static_cast<size_t>(entry["total_states"].number);
+    }
+    results.push_back(std::move(r));
+  }
+  return results;
+}
+
+double median(std::vector<double> sample) {
+  std::sort(sample.begin(), sample.end());
+  const size_t h = sample.size() / 2;
+  return sample.size() % 2 == 1 ? sample[h] : (sample[h - 1] + sample[h]) / 2.0;
+}
+
+template <typename Statistic>
+ratio_interval bootstrap(double ratio, const regression_config &config, std::mt19937_64 &rng, Statistic &&resample) {
+  std::vector<double> ratios(config.resamples);
+  for (auto &r : ratios) {
+    r = resample(rng);
+  }
+  std::sort(ratios.begin(), ratios.end());
+  const double alpha = (1.0 - config.confidence) / 2.0;
+  return {ratio, percentile(ratios, 100.0 * alpha), percentile(ratios, 100.0 * (1.0 - alpha))};
+}
+
+ratio_interval instance_ratio(const std::vector<double> &baseline, const std::vector<double> &current,
+                              const regression_config &config, std::mt19937_64 &rng) {
+  auto draw = [](const std::vector<double> &sample, std::mt19937_64 &g) {
+    std::uniform_int_distribution<size_t> pick(0, sample.size() - 1);
+    std::vector<double> resampled(sample.size());
+    for (auto &x : resampled) {
+      x = sample[pick(g)];
+    }
+    return median(resampled);
+  };
+  const double ratio = median(current) / median(baseline);
+  return bootstrap(ratio, config, rng, [&](std::mt19937_64 &g) { return draw(current, g) / draw(baseline, g); });
+}
+
+ratio_interval family_ratio(const std::vector<double> &log_ratios, const regression_config &config,
+                            std::mt19937_64 &rng) {
+  auto geomean = [](const std::vector<double> &logs) {
+    return std::exp(std::accumulate(logs.begin(), logs.end(), 0.0) / logs.size());
+  };
+  std::uniform_int_distribution<size_t> pick(0, log_ratios.size() - 1);
+  return bootstrap(geomean(log_ratios), config, rng, [&](std::mt19937_64 &g) {
+    std::vector<double> resampled(log_ratios.size());
+    for (auto &x : resampled) {
+      x = log_ratios[pick(g)];
+    }
+    return geomean(resampled);
+  });
+}
+
+// Prints the comparison and returns the number of regressions found.
+size_t compare_results(const std::vector<bench_result> &baseline, const std::vector<bench_result> &current,
+                       const regression_config &config) {
+  std::mt19937_64 rng(config.seed);
+  std::map<std::string, const bench_result *> by_path;
+  for (auto const &r : baseline) {
+    by_path[r.instance.path] = &r;
+  }
+
+  // Log ratios of time and peak RSS of the instances of each family.
+  struct family_logs {
+    std::vector<double> time;
+    std::vector<double> rss;
+  };
+  auto measured = [](const std::vector<double> &rss) {
+    return !rss.empty() && std::all_of(rss.begin(), rss.end(), [](double x) { return x > 0.0; });
+  };
+
+  size_t regressions = 0;
+  std::map<std::string, family_logs> families;
+  for (auto const &r : current) {
+    auto it = by_path.find(r.instance.path);
+    if (it == by_path.end()) {
+      continue;
+    }
+    auto const &b = *it->second;
+    auto &family = families[fmt::format("{}/{}D", instance_types[r.instance.type], r.instance.m)];
+    const auto ci = instance_ratio(b.times, r.times, config, rng);
+    const bool slower = ci.low > 1.0 + config.threshold;
+    const bool faster = ci.high < 1.0 - config.threshold;
+    family.time.push_back(std::log(ci.ratio));
+    auto rss = ratio_interval{};
+    if (measured(b.rss_kb) && measured(r.rss_kb)) {
+      rss = instance_ratio(b.rss_kb, r.rss_kb, config, rng);
+      family.rss.push_back(std::log(rss.ratio));
+    }
+    const bool memory = rss.low > 1.0 + config.memory_threshold;
+    const bool front = b.front_ok && !r.front_ok;
+    regressions += slower + memory + front;
+
+    fmt::print("{} time x{:.3f} [{:.3f}, {:.3f}] rss x{:.3f} [{:.3f}, {:.3f}] {}->{}KiB{}{}{}{}\n", r.instance.path,
+               ci.ratio, ci.low, ci.high, rss.ratio, rss.low, rss.high, b.peak_rss_kb, r.peak_rss_kb,
+               slower ? " SLOWER" : "", faster ? " faster" : "", memory ? " MEMORY" : "", front ? " FRONT" : "");
+  }
+
+  for (auto const &[family, logs] : families) {
+    const auto ci = family_ratio(logs.time, config, rng);
+    const auto rss = logs.rss.empty() ? ratio_interval{} : family_ratio(logs.rss, config, rng);
+    const bool slower = ci.low > 1.0 + config.threshold;
+    const bool memory = rss.low > 1.0 + config.memory_threshold;
+    regressions += slower + memory;
+    fmt::print("{} ({} instances) time x{:.3f} [{:.3f}, {:.3f}] rss x{:.3f} [{:.3f}, {:.3f}]{}{}\n", family,
+               logs.time.size(), ci.ratio, ci.low, ci.high, rss.ratio, rss.low, rss.high, slower ? " SLOWER" : "",
+               memory ? " MEMORY" : "");
+  }
+  fmt::print("{} regression(s) found\n", regressions);
+  return regressions;
+}
+
+#endif  // REGRESSION_HPP
@@ -5,6 +5,10 @@
 
 #include <parser.hpp>
 #include <solver.hpp>
+#include <shard.hpp>
+#include <daemon.hpp>
+#include <search.hpp>
+#include <sweep.hpp>
 
 int main(int argc, char* argv[]) {
   if (argc < 2) {
@@ -13,17 +17,38 @@ int main(int argc, char* argv[]) {
   }
 
   Arguments args(argc, argv);
+  if (!args.get_trace().empty()) {
+    trace_enable();
+  }
+  if (!args.get_shard_dir().empty()) {
+    run_shard_worker(args);
+  } else if (!args.get_daemon().empty()) {
+    generation_daemon(args.get_daemon(), args.get_workers(), args.get_numa()).serve();
+  } else if (args.get_target_front() > 0) {
+    auto search = front_search(args);
+    search.run();
+    search.solve_best();
+  } else if (!args.get_n_sweep().empty()) {
+    size_sweep(args).run();
+  } else {
+    switch(args.get_type()) {
+      case 0:
+        generate_random_mobkp_test(args);
+        break;
+      case 1:
+        generate_corr_mobkp_test(args);
+        break;
+      case 2:
+        generate_corr_mobkp_test(args);
+        break;
+      case 3:
+        generate_bounded_mobkp_test(args);
+        break;
+    }
+  }
 
-  switch(args.get_type()) {
-    case 0:
-      generate_random_mobkp_test(args);
-      break;
-    case 1:
-      generate_corr_mobkp_test(args);
-      break;
-    case 2:
-      generate_corr_mobkp_test(args);
-      break;
+  if (!args.get_trace().empty()) {
+    trace_dump(args.get_trace());
   }
 
   return 0;
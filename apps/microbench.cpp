@@ -0,0 +1,138 @@
+#include <cstdio>
+#include <cstdlib>
+#include <iostream>
+
+#include <parser.hpp>
+#include <solver.hpp>
+#include <microbench.hpp>
+
+// Minimal solution holding only an objective vector, to time set insertions.
+struct point_solution {
+  ovec_type ov;
+  const ovec_type &objective_vector() const { return ov; }
+};
+
+template <typename T>
+void bench_dominance(const std::vector<int64_t> &layer, size_t m, size_t size, double min_time, const std::string &type) {
+  const auto layout = state_layout<T>{m, 1};
+  const size_t width = layout.width();
+  const std::vector<T> states(layer.begin(), layer.begin() + size * width);
+  const double ns = measure(min_time, size * size, [&]() {
+    size_t dominated = 0;
+    for (size_t a = 0; a < states.size(); a += width) {
+      for (size_t b = 0; b < states.size(); b += width) {
+        dominated += layout.dominates(states.data() + a, states.data() + b);
+      }
+    }
+    do_not_optimize(dominated);
+  });
+  print_measurement("dominance", m, type, size, ns, 2 * width * sizeof(T));
+}
+
+// Extends the first `size` states of the layer by `item` with the steps of
+// the layered DP: `shift_layer`, `merge_layers` and `filter_merged`, each
+// timed per input state.
+template <typename T>
+void bench_extend(const std::vector<int64_t> &layer, const instance_file &instance, size_t item, size_t size,
+                  double min_time, const std::string &type) {
+  const size_t m = instance.m;
+  const auto layout = state_layout<T>{m, 1};
+  const size_t width = layout.width();
+  const state_vector<T> states(layer.begin(), layer.begin() + size * width);
+  const auto problem =
+      mobkp::problem<T>(instance.n, m, 1, std::vector<T>(instance.points.begin(), instance.points.end()));
+  const std::vector<T> capacity = {problem.weight_capacity(0)};
+  auto stats = no_stats{};
+  state_vector<T> shifted, merged, filtered;
+  std::vector<uint8_t> from_shifted;
+
+  const double shift_ns = measure(min_time, size, [&]() {
+    shift_layer(problem, item, capacity, states, shifted, stats);
+    do_not_optimize(shifted.size());
+  });
+  print_measurement("shift", m, type, size, shift_ns, 2 * width * sizeof(T));
+
+  const size_t merge_inputs = (states.size() + shifted.size()) / width;
+  const double merge_ns = measure(min_time, merge_inputs, [&]() {
+    merge_layers(layout, states, shifted, merged, from_shifted);
+    do_not_optimize(merged.size());
+  });
+  print_measurement("merge", m, type, size, merge_ns, 2 * width * sizeof(T));
+
+  const double filter_ns = measure(min_time, merged.size() / width, [&]() {
+    filter_merged(layout, merged, from_shifted, filtered, stats);
+    do_not_optimize(filtered.size());
+  });
+  print_measurement("filter", m, type, size, filter_ns, 2 * width * sizeof(T));
+}
+
+void bench_unordered_set(const std::vector<int64_t> &layer, size_t m, size_t size, double min_time) {
+  const size_t width = m + 1;
+  std::vector<ovec_type> points;
+  for (size_t s = 0; s < size * width; s += width) {
+    points.emplace_back(layer.begin() + s, layer.begin() + s + m);
+  }
+  const double ns = measure(min_time, size, [&]() {
+    auto set = mooutils::unordered_set<point_solution>();
+    for (auto const &p : points) {
+      set.insert(point_solution{p});
+    }
+    do_not_optimize(set.size());
+  });
+  print_measurement("unordered_set", m, "int64", size, ns, m * sizeof(data_type));
+}
+
+void bench_incremental_hv(const std::vector<int64_t> &layer, size_t m, size_t size, double min_time) {
+  const size_t width = m + 1;
+  std::vector<ovec_type> points;
+  for (size_t s = 0; s < size * width; s += width) {
+    points.emplace_back(layer.begin() + s, layer.begin() + s + m);
+  }
+  const auto hvref = ovec_type(m, -1);
+  const double ns = measure(min_time, size, [&]() {
+    auto hv = mooutils::incremental_hv<hv_data_type, ovec_type>(hvref);
+    for (auto const &p : points) {
+      hv.insert(p);
+    }
+    do_not_optimize(hv);
+  });
+  print_measurement("incremental_hv", m, "int256", size, ns, m * sizeof(data_type));
+}
+
+int main(int argc, char* argv[]) {
+  MicrobenchArguments args(argc, argv);
+  const auto sizes = args.get_sizes();
+  const size_t max_size = *std::max_element(sizes.begin(), sizes.end());
+
+  for (auto m : args.get_ms()) {
+    const auto path = largest_instance(args.get_instances_dir(), m);
+    if (path.empty()) {
+      fmt::print("No random {}D instance found in {}\n", m, args.get_instances_dir());
+      continue;
+    }
+    const auto instance = read_instance(path);
+    size_t items = 0;
+    const auto layer = extract_layer(instance, max_size, items);
+    const size_t available = layer.size() / (m + 1);
+    // The item after the layer, or the last one when the layer covers them all.
+    const size_t item = std::min<size_t>(items, instance.n - 1);
+    fmt::print("{}: {} states sampled after {} items\n", path, available, items);
+
+    for (auto requested : sizes) {
+      const size_t size = std::min<size_t>(requested, available);
+      bench_dominance<int32_t>(layer, m, size, args.get_min_time(), "int32");
+      bench_dominance<int64_t>(layer, m, size, args.get_min_time(), "int64");
+      bench_dominance<double>(layer, m, size, args.get_min_time(), "double");
+      bench_extend<int32_t>(layer, instance, item, size, args.get_min_time(), "int32");
+      bench_extend<int64_t>(layer, instance, item, size, args.get_min_time(), "int64");
+      bench_extend<double>(layer, instance, item, size, args.get_min_time(), "double");
+      bench_unordered_set(layer, m, size, args.get_min_time());
+      bench_incremental_hv(layer, m, size, args.get_min_time());
+      if (size == available) {
+        break;
+      }
+    }
+  }
+
+  return 0;
+}
@@ -0,0 +1,456 @@
+#ifndef BNB_HPP
+#define BNB_HPP
+
+#include <algorithm>
+#include <atomic>
+#include <chrono>
+#include <cstdint>
+#include <deque>
+#include <limits>
+#include <memory>
+#include <mutex>
+#include <numeric>
+#include <random>
+#include <thread>
+#include <utility>
+#include <vector>
+
+#include <layered_dp.hpp>
+#include <pages.hpp>
+#include <progress.hpp>
+#include <trace.hpp>
+
+// Parallel multi-objective branch and bound for the MOBKP.
+//
+// A node fixes the first `depth` items (in decreasing order of efficiency) to
+// in or out. Its upper bound is the ideal point of the relaxation of the free
+// items: per objective, the smallest over the constraints of the fractional
+// knapsack bound within the slack, which is the LP bound when k = 1. A node
+// is pruned when a point of the incumbent archive is at least its bound and
+// differs from it; as in the presolve pruning of the DPs, no point of the
+// front is lost, so the front is exact.
+//
+// An ideal point is a loose bound when the objectives conflict, so for m = 2
+// and k = 1 a node is bounded by a bound set instead: the ideal box cut by the
+// LP bounds of fixed weightings of the objectives. The archive is then kept as
+// a staircase, and the node is pruned when none of the local upper points of
+// the staircase (the corners of the region it does not weakly dominate) within
+// the ideal point lies in the bound set. Its completions are then weakly
+// dominated by archived points, which are part of the front.
+//
+// Each worker explores its nodes depth first from the back of its own deque,
+// and idle workers steal from the front of another deque, where the largest
+// subtrees are. Every worker prunes against its own archive; points entering
+// it are also appended to a shared log with a fetch_add on its size and a
+// per-slot ready flag, from which the others import them without locking.
+// Once the log is full, further points go to an overflow archive under a lock.
+
+struct bnb_node {
+  uint32_t depth = 0;
+  uint32_t offset = 0;  // of the node's values and weights in the worker's node store
+};
+
+template <typename T>
+class bnb_solver {
+ public:
+  template <typename Problem>
+  bnb_solver(const Problem &problem, size_t threads, progress_counters *counters)
+      : n(problem.num_items()), m(problem.num_objectives()), k(problem.num_constraints()),
+        threads(std::max<size_t>(1, threads)), counters(counters), bound_sets(m == 2 && k == 1), capacity(k),
+        log_points(log_capacity * m), log_ready(log_capacity) {
+    for (size_t c = 0; c < k; ++c) {
+      capacity[c] = problem.weight_capacity(c);
+    }
+    // Branch on efficient items first, their subtrees hold the good solutions.
+    std::vector<double> efficiency(n);
+    for (size_t i = 0; i < n; ++i) {
+      auto v = problem.item_values(i);
+      auto w = problem.item_weights(i);
+      double load = 1e-9;
+      for (size_t c = 0; c < k; ++c) {
+        load += capacity[c] > 0 ? static_cast<double>(w[c]) / capacity[c] : 0.0;
+      }
+      efficiency[i] = std::accumulate(v.begin(), v.end(), 0.0) / load;
+    }
+    std::vector<size_t> order(n);
+    std::iota(order.begin(), order.end(), 0);
+    std::stable_sort(order.begin(), order.end(), [&](size_t a, size_t b) { return efficiency[a] > efficiency[b]; });
+    values.resize(n * m);
+    weights.resize(n * k);
+    for (size_t i = 0; i < n; ++i) {
+      auto v = problem.item_values(order[i]);
+      auto w = problem.item_weights(order[i]);
+      std::copy(v.begin(), v.end(), values.begin() + i * m);
+      std::copy(w.begin(), w.end(), weights.begin() + i * k);
+    }
+    ratio_order.resize(m * k);
+    for (size_t j = 0; j < m; ++j) {
+      for (size_t c = 0; c < k; ++c) {
+        auto &items = ratio_order[j * k + c];
+        items.resize(n);
+        std::iota(items.begin(), items.end(), 0);
+        std::sort(items.begin(), items.end(), [&](size_t a, size_t b) {
+          return values[a * m + j] * weights[b * k + c] > values[b * m + j] * weights[a * k + c];
+        });
+      }
+    }
+    if (bound_sets) {
+      for (T t = 1; t < bound_weightings; ++t) {
+        auto &items = weighted_order.emplace_back(n);
+        std::iota(items.begin(), items.end(), 0);
+        std::sort(items.begin(), items.end(), [&](size_t a, size_t b) {
+          return weighted(t, a) * weights[b] > weighted(t, b) * weights[a];
+        });
+      }
+    }
+    min_weight.assign((n + 1) * k, std::numeric_limits<T>::max());
+    for (size_t i = n; i-- > 0;) {
+      for (size_t c = 0; c < k; ++c) {
+        min_weight[i * k + c] = std::min(min_weight[(i + 1) * k + c], weights[i * k + c]);
+      }
+    }
+  }
+
+  // Exact front, or the points found so far when the timeout is reached.
+  // `seed` holds feasible points (e.g. a presolve front) to prune with from the start.
+  std::vector<std::vector<T>> solve(double timeout, const std::vector<std::vector<T>> &seed = {}) {
+    MOBKP_TRACE_SPAN("bnb", "solve");
+    deadline = std::chrono::steady_clock::now() +
+               std::chrono::duration_cast<std::chrono::steady_clock::duration>(std::chrono::duration<double>(timeout));
+    workers.clear();
+    for (size_t t = 0; t < threads; ++t) {
+      workers.push_back(std::make_unique<worker>());
+      for (auto const &p : seed) {
+        insert(*workers[t], p.data());
+      }
+    }
+    // The root: nothing fixed, no value and no weight.
+    auto &root = *workers[0];
+    root.store.assign(m + k, 0);
+    root.nodes.push_back(bnb_node{0, 0});
+    pending.store(1);
+
+    if (threads == 1) {
+      run(0);
+    } else {
+      std::vector<std::thread> pool;
+      for (size_t t = 0; t < threads; ++t) {
+        pool.emplace_back([this, t]() { run(t); });
+      }
+      for (auto &thread : pool) {
+        thread.join();
+      }
+    }
+    if (counters != nullptr && counters->cancelled.load()) {
+      throw solve_cancelled();
+    }
+    state_vector<T> points;
+    for (auto const &w : workers) {
+      points.insert(points.end(), w->archive.begin(), w->archive.end());
+    }
+    return front_of_states(points, m, m);
+  }
+
+ private:
+  static constexpr size_t log_capacity = size_t(1) << 16;
+  // The bound sets use the weightings (t, bound_weightings - t) for 0 < t < bound_weightings.
+  static constexpr T bound_weightings = 16;
+
+  struct worker {
+    std::mutex mutex;  // of `nodes` and `store`, taken by the owner and by thieves
+    std::deque<bnb_node> nodes;
+    std::vector<T> store;  // values and weights of the nodes, in push order
+    std::vector<T> archive;  // m values per point
+    std::vector<T> archive_sum;
+    std::vector<std::pair<T, T>> staircase;  // the archive by increasing first value, with bound sets
+    std::vector<T> limits;     // LP bounds of the weightings for the node being bounded
+    size_t imported = 0;  // log entries already imported
+    size_t imported_overflow = 0;
+  };
+
+  size_t n, m, k, threads;
+  progress_counters *counters;
+  bool bound_sets;
+  std::vector<T> capacity;
+  std::vector<T> values;
+  std::vector<T> weights;
+  std::vector<std::vector<size_t>> ratio_order;
+  std::vector<std::vector<size_t>> weighted_order;  // items by weighted efficiency, with bound sets
+  std::vector<T> min_weight;  // of the items from each depth on
+  std::vector<std::unique_ptr<worker>> workers;
+  std::atomic<size_t> pending{0};
+  std::atomic<bool> stopped{false};
+  std::chrono::steady_clock::time_point deadline;
+
+  std::vector<T> log_points;
+  std::vector<std::atomic<uint8_t>> log_ready;
+  std::atomic<size_t> log_size{0};
+  std::mutex overflow_mutex;
+  std::vector<T> overflow;  // points published after the log filled, m values each
+
+  // Adds a point to the worker's archive unless a point of it covers it.
+  bool insert(worker &w, const T *p) {
+    const T sum = std::accumulate(p, p + m, T(0));
+    for (size_t a = 0; a < w.archive_sum.size(); ++a) {
+      if (w.archive_sum[a] >= sum && std::equal(p, p + m, w.archive.begin() + a * m, [](T x, T y) { return y >= x; })) {
+        return false;
+      }
+    }
+    size_t kept = 0;
+    for (size_t a = 0; a < w.archive_sum.size(); ++a) {
+      const bool covered =
+          sum >= w.archive_sum[a] && std::equal(p, p + m, w.archive.begin() + a * m, [](T x, T y) { return x >= y; });
+      if (!covered) {
+        std::copy(w.archive.begin() + a * m, w.archive.begin() + (a + 1) * m, w.archive.begin() + kept * m);
+        w.archive_sum[kept++] = w.archive_sum[a];
+      }
+    }
+    w.archive.resize(kept * m);
+    w.archive_sum.resize(kept);
+    w.archive.insert(w.archive.end(), p, p + m);
+    w.archive_sum.push_back(sum);
+    if (bound_sets) {
+      // The points p weakly dominates come just before its position, the
+      // second values decreasing along the staircase.
+      auto &s = w.staircase;
+      const auto end = std::upper_bound(s.begin(), s.end(), std::make_pair(p[0], std::numeric_limits<T>::max()));
+      const auto begin = std::partition_point(s.begin(), end, [&](auto const &f) { return f.second > p[1]; });
+      s.insert(s.erase(begin, end), std::make_pair(p[0], p[1]));
+    }
+    return true;
+  }
+
+  // Inserts a point found by the worker and shares it with the others.
+  void publish(worker &w, const T *p) {
+    if (!insert(w, p)) {
+      return;
+    }
+    const size_t slot = log_size.fetch_add(1, std::memory_order_relaxed);
+    if (slot < log_capacity) {
+      std::copy(p, p + m, log_points.begin() + slot * m);
+      log_ready[slot].store(1, std::memory_order_release);
+    } else {
+      std::lock_guard<std::mutex> lock(overflow_mutex);
+      overflow.insert(overflow.end(), p, p + m);
+    }
+  }
+
+  void import(worker &w) {
+    const size_t published = log_size.load(std::memory_order_relaxed);
+    const size_t size = std::min(published, log_capacity);
+    while (w.imported < size && log_ready[w.imported].load(std::memory_order_acquire)) {
+      insert(w, log_points.data() + w.imported * m);
+      ++w.imported;
+    }
+    if (published > log_capacity && w.imported == log_capacity) {
+      std::vector<T> points;
+      {
+        std::lock_guard<std::mutex> lock(overflow_mutex);
+        points.assign(overflow.begin() + w.imported_overflow * m, overflow.end());
+      }
+      for (size_t a = 0; a < points.size(); a += m) {
+        insert(w, points.data() + a);
+      }
+      w.imported_overflow += points.size() / m;
+    }
+  }
+
+  // Whether a point of the archive is at least `bound` and differs from it.
+  bool covered(const worker &w, const std::vector<T> &bound, T bound_sum) const {
+    for (size_t a = 0; a < w.archive_sum.size(); ++a) {
+      if (w.archive_sum[a] > bound_sum &&
+          std::equal(bound.begin(), bound.end(), w.archive.begin() + a * m, [](T u, T p) { return p >= u; })) {
+        return true;
+      }
+    }
+    return false;
+  }
+
+  // Value of objective j the items from `depth` on add within `slack` of
+  // constraint c when they may be taken fractionally.
+  T fractional_bound(size_t depth, size_t j, size_t c, T slack) const {
+    T bound = 0;
+    for (auto i : ratio_order[j * k + c]) {
+      if (i < depth) {
+        continue;
+      }
+      const T w = weights[i * k + c];
+      if (w <= slack) {
+        slack -= w;
+        bound += values[i * m + j];
+      } else {
+        bound += values[i * m + j] * slack / w;
+        break;
+      }
+    }
+    return bound;
+  }
+
+  T weighted(T t, size_t i) const { return t * values[i * 2] + (bound_weightings - t) * values[i * 2 + 1]; }
+
+  // LP bound of the weighted value (t, bound_weightings - t) the items from
+  // `depth` on add within `slack`, with bound sets.
+  T weighted_bound(size_t depth, T t, T slack) const {
+    T bound = 0;
+    for (auto i : weighted_order[t - 1]) {
+      if (i < depth) {
+        continue;
+      }
+      if (weights[i] <= slack) {
+        slack -= weights[i];
+        bound += weighted(t, i);
+      } else {
+        bound += weighted(t, i) * slack / weights[i];
+        break;
+      }
+    }
+    return bound;
+  }
+
+  // Whether a completion of the node, with values at most `ideal`, may be
+  // outside the region the staircase weakly dominates: some local upper point
+  // (f[a-1][0] + 1, f[a][1] + 1) of the staircase f, clamped to the node's
+  // values, is within the LP bounds of every weighting.
+  bool reachable(worker &w, const std::vector<T> &state, size_t depth, const std::vector<T> &ideal) {
+    const auto &s = w.staircase;
+    const T lowest = std::numeric_limits<T>::lowest();
+    auto upper1 = [&](size_t a) { return a == 0 ? lowest : s[a - 1].first + 1; };
+    auto upper2 = [&](size_t a) { return a == s.size() ? lowest : s[a].second + 1; };
+    // The upper points within the ideal point are those from `first` to `last`,
+    // the first values increasing and the second decreasing along the staircase.
+    const size_t last =
+        std::partition_point(s.begin(), s.end(), [&](auto const &f) { return f.first + 1 <= ideal[0]; }) - s.begin() + 1;
+    const size_t first =
+        std::partition_point(s.begin(), s.begin() + std::min(last, s.size()),
+                             [&](auto const &f) { return f.second + 1 > ideal[1]; }) -
+        s.begin();
+    const T slack = capacity[0] - state[2];
+    w.limits.assign(bound_weightings, -1);
+    for (size_t a = first; a < last; ++a) {
+      const T d1 = std::max(upper1(a), state[0]) - state[0];
+      const T d2 = std::max(upper2(a), state[1]) - state[1];
+      bool inside = true;
+      for (T t = 1; t < bound_weightings && inside; ++t) {
+        if (w.limits[t] < 0) {
+          w.limits[t] = weighted_bound(depth, t, slack);
+        }
+        inside = t * d1 + (bound_weightings - t) * d2 <= w.limits[t];
+      }
+      if (inside) {
+        return true;
+      }
+    }
+    return false;
+  }
+
+  bool pop(size_t t, bnb_node &node, std::vector<T> &state) {
+    auto try_take = [&](worker &w, bool back) {
+      std::lock_guard<std::mutex> lock(w.mutex);
+      if (w.nodes.empty()) {
+        return false;
+      }
+      node = back ? w.nodes.back() : w.nodes.front();
+      back ? w.nodes.pop_back() : w.nodes.pop_front();
+      state.assign(w.store.begin() + node.offset, w.store.begin() + node.offset + m + k);
+      // The back node was pushed last, so its owner's store shrinks with the
+      // depth-first stack; the holes left by thieves go when the deque empties.
+      if (w.nodes.empty()) {
+        w.store.clear();
+      } else if (back) {
+        w.store.resize(node.offset);
+      }
+      return true;
+    };
+    if (try_take(*workers[t], true)) {
+      return true;
+    }
+    auto rng = std::minstd_rand(static_cast<uint32_t>(t + 1));
+    for (size_t attempt = 0; attempt < 2 * threads; ++attempt) {
+      const size_t victim = rng() % threads;
+      if (victim != t && try_take(*workers[victim], false)) {
+        return true;
+      }
+    }
+    return false;
+  }
+
+  void push(worker &w, uint32_t depth, const std::vector<T> &state) {
+    std::lock_guard<std::mutex> lock(w.mutex);
+    w.nodes.push_back(bnb_node{depth, static_cast<uint32_t>(w.store.size())});
+    w.store.insert(w.store.end(), state.begin(), state.end());
+  }
+
+  void run(size_t t) {
+    auto &self = *workers[t];
+    bnb_node node;
+    std::vector<T> state, child, bound(m);
+    size_t visited = 0;
+    while (pending.load() > 0 && !stopped.load(std::memory_order_relaxed)) {
+      if (!pop(t, node, state)) {
+        std::this_thread::yield();
+        continue;
+      }
+      if (++visited % 1024 == 0) {
+        import(self);
+        const bool cancelled = counters != nullptr && counters->cancelled.load(std::memory_order_relaxed);
+        if (cancelled || std::chrono::steady_clock::now() > deadline) {
+          stopped.store(true);
+        }
+      }
+      expand(self, node.depth, state, child, bound);
+      pending.fetch_sub(1);
+    }
+  }
+
+  void expand(worker &self, size_t depth, const std::vector<T> &state, std::vector<T> &child, std::vector<T> &bound) {
+    // Skip the free items that do not fit: a node where none does is a solution.
+    auto fits = [&](const T *item_weights) {
+      bool fit = true;
+      for (size_t c = 0; c < k; ++c) {
+        fit &= state[m + c] + item_weights[c] <= capacity[c];
+      }
+      return fit;
+    };
+    while (depth < n && !fits(weights.data() + depth * k)) {
+      depth = fits(min_weight.data() + (depth + 1) * k) ? depth + 1 : n;
+    }
+    if (depth == n) {
+      publish(self, state.data());
+      return;
+    }
+
+    T bound_sum = 0;
+    for (size_t j = 0; j < m; ++j) {
+      T gain = std::numeric_limits<T>::max();
+      for (size_t c = 0; c < k; ++c) {
+        gain = std::min(gain, fractional_bound(depth, j, c, capacity[c] - state[m + c]));
+      }
+      bound[j] = state[j] + gain;
+      bound_sum += bound[j];
+    }
+    if (bound_sets ? !reachable(self, state, depth, bound) : covered(self, bound, bound_sum)) {
+      return;
+    }
+
+    // Out first, so the in branch is explored next from the back of the deque.
+    pending.fetch_add(2);
+    push(self, static_cast<uint32_t>(depth + 1), state);
+    child = state;
+    for (size_t j = 0; j < m; ++j) {
+      child[j] += values[depth * m + j];
+    }
+    for (size_t c = 0; c < k; ++c) {
+      child[m + c] += weights[depth * k + c];
+    }
+    push(self, static_cast<uint32_t>(depth + 1), child);
+  }
+};
+
+template <typename T, typename Problem>
+std::vector<std::vector<T>> bnb_solve(const Problem &problem, double timeout, size_t threads,
+                                      const std::vector<std::vector<T>> &seed = {},
+                                      progress_counters *counters = nullptr) {
+  return bnb_solver<T>(problem, threads, counters).solve(timeout, seed);
+}
+
+#endif  // BNB_HPP
@@ -0,0 +1,321 @@
+#ifndef CORE_HPP
+#define CORE_HPP
+
+#include <fmt/core.h>
+
+#include <algorithm>
+#include <chrono>
+#include <cstdint>
+#include <numeric>
+#include <stdexcept>
+#include <vector>
+
+#include <mobkp/problem.hpp>
+
+#include <layered_dp.hpp>
+#include <presolve.hpp>
+#include <progress.hpp>
+#include <stats.hpp>
+#include <trace.hpp>
+
+// Core-problem acceleration of bi-objective, single-constraint instances.
+//
+// For a weighting l of the two objectives, the items sorted by decreasing
+// weighted efficiency l.v / w are almost always packed before the break item
+// (the first that no longer fits greedily) and left out after it, except in a
+// window around it. An item before the window for every weighting of a set is
+// fixed in, one after it for every weighting is fixed out, and the rest form
+// the core, which is solved with the layered DP at the capacity left by the
+// fixed items. The weightings are those of the edges of the convex hull of
+// the last front (its supported points) and the two objectives. The core DP
+// drops the states whose completions the known solutions (a presolve front,
+// then the last front) cover, see bound_set_pruner.
+//
+// The front F of the core is the exact front when every solution flipping a
+// fixed item is strictly dominated by a point of F. Such solutions y satisfy
+// l.y <= UB(l), the LP bound of the weighted knapsack with that item flipped;
+// a point not weakly dominated by F is at least one of the local upper points
+// of F, (f_a.1 + 1, f_a+1.2 + 1) for consecutive points sorted by the first
+// objective, so it suffices that each of those points has a weighting l with
+// l.u > UB(l). Fixed items failing the test join the core for good, the
+// window doubles when they outnumber it, and the core is solved again until
+// all fixed items pass.
+
+template <typename T>
+class core_solver {
+ public:
+  template <typename Problem>
+  core_solver(const Problem &problem, size_t threads, progress_counters &counters, bool report)
+      : n(problem.num_items()), capacity(problem.weight_capacity(0)), value1(n), value2(n), weight(n),
+        counters(counters), report(report) {
+    if (problem.num_objectives() != 2 || problem.num_constraints() != 1) {
+      throw std::invalid_argument("The core solver needs a bi-objective instance with a single constraint.");
+    }
+    for (size_t i = 0; i < n; ++i) {
+      auto v = problem.item_values(i);
+      value1[i] = v[0];
+      value2[i] = v[1];
+      weight[i] = problem.item_weights(i)[0];
+    }
+    lower = presolve_front<T>(problem, presolve_budget, threads);
+  }
+
+  std::vector<std::vector<T>> solve(double timeout) {
+    MOBKP_TRACE_SPAN("core_dp", "dp");
+    const auto start = std::chrono::steady_clock::now();
+    auto elapsed = [&]() { return std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count(); };
+
+    // Until a first front is known, the weightings are spread evenly.
+    std::vector<weighting> weightings;
+    for (T t = 0; t <= 8; ++t) {
+      weightings.push_back(make_weighting(t, 8 - t));
+    }
+    // 0: core, 1: fixed in, 2: fixed out.
+    std::vector<uint8_t> status(n, 0);
+    std::vector<uint8_t> forced(n, 0);  // failed a test, never fixed again
+    size_t window = std::max<size_t>(8, n / 50);
+
+    // The pruning of the first core needs known solutions close to the whole
+    // front: the small cores of single weightings give the parts of the front
+    // around their supported points.
+    for (T t = 0; t <= seed_weightings && elapsed() < timeout; ++t) {
+      const auto single = std::vector<weighting>{make_weighting(t, seed_weightings - t)};
+      classify(single, window, forced, status);
+      lower = solve_core(status, single[0], lower, timeout - elapsed());
+    }
+    if (report) {
+      fmt::print(stderr, "[core] seeded with {} known points, {:.1f} s\n", lower.size(), elapsed());
+    }
+    for (size_t round = 1;; ++round) {
+      classify(weightings, window, forced, status);
+      auto front = solve_core(status, weightings[weightings.size() / 2], lower, timeout - elapsed());
+      if (elapsed() > timeout) {
+        return front;
+      }
+      lower = front;
+      weightings = hull_weightings(front);
+      size_t failed = 0;
+      for (size_t i = 0; i < n; ++i) {
+        if (status[i] != 0 && !provably_fixed(i, status[i] == 1, front, weightings)) {
+          forced[i] = 1;
+          ++failed;
+        }
+      }
+      const size_t core = static_cast<size_t>(std::count(status.begin(), status.end(), 0));
+      if (report) {
+        fmt::print(stderr, "[core] round {}: core of {} of {} items, front of {} points, {} fixed items unproven, {:.1f} s\n",
+                   round, core, n, front.size(), failed, elapsed());
+      }
+      if (failed == 0) {
+        return front;
+      }
+      // Many failures mean the window misses the break regions, not a few items.
+      if (failed > window) {
+        window *= 2;
+      }
+    }
+  }
+
+ private:
+  // A weighting of the objectives with the items in decreasing order of
+  // weighted efficiency and the prefix sums of their weights and weighted values.
+  struct weighting {
+    T l1, l2;
+    std::vector<size_t> order;
+    std::vector<size_t> position;
+    std::vector<T> prefix_weight;
+    std::vector<T> prefix_value;
+    size_t break_item = 0;  // position of the first item that no longer fits greedily
+  };
+
+  // Seconds of the presolve giving the first known solutions.
+  static constexpr double presolve_budget = 0.2;
+  // Weightings whose single cores seed the known solutions.
+  static constexpr T seed_weightings = 32;
+
+  size_t n;
+  T capacity;
+  std::vector<T> value1, value2, weight;
+  progress_counters &counters;
+  bool report;
+  std::vector<std::vector<T>> lower;  // known solutions, non-dominated
+
+  T weighted(const weighting &l, size_t i) const { return l.l1 * value1[i] + l.l2 * value2[i]; }
+
+  weighting make_weighting(T l1, T l2) const {
+    auto l = weighting{l1, l2, std::vector<size_t>(n), std::vector<size_t>(n), {0}, {0}};
+    std::iota(l.order.begin(), l.order.end(), 0);
+    std::stable_sort(l.order.begin(), l.order.end(), [&](size_t a, size_t b) {
+      return weighted(l, a) * weight[b] > weighted(l, b) * weight[a];
+    });
+    for (size_t p = 0; p < n; ++p) {
+      const size_t i = l.order[p];
+      l.position[i] = p;
+      l.prefix_weight.push_back(l.prefix_weight.back() + weight[i]);
+      l.prefix_value.push_back(l.prefix_value.back() + weighted(l, i));
+    }
+    l.break_item = std::upper_bound(l.prefix_weight.begin(), l.prefix_weight.end(), capacity) - l.prefix_weight.begin() - 1;
+    return l;
+  }
+
+  // Weightings normal to the edges of the upper convex hull of the front, and the two objectives.
+  std::vector<weighting> hull_weightings(std::vector<std::vector<T>> front) const {
+    std::sort(front.begin(), front.end());
+    std::vector<std::vector<T>> hull;
+    for (auto &p : front) {
+      // Drop the last hull point while it is on or below the segment to p.
+      while (hull.size() >= 2) {
+        const auto &a = hull[hull.size() - 2];
+        const auto &b = hull.back();
+        const T cross = (b[0] - a[0]) * (p[1] - a[1]) - (b[1] - a[1]) * (p[0] - a[0]);
+        if (cross < 0) {
+          break;
+        }
+        hull.pop_back();
+      }
+      hull.push_back(p);
+    }
+    std::vector<weighting> weightings = {make_weighting(1, 0), make_weighting(0, 1)};
+    for (size_t h = 1; h < hull.size(); ++h) {
+      T l1 = hull[h - 1][1] - hull[h][1];
+      T l2 = hull[h][0] - hull[h - 1][0];
+      const T g = std::gcd(l1, l2);
+      if (g > 0 && l1 > 0 && l2 > 0) {
+        weightings.push_back(make_weighting(l1 / g, l2 / g));
+      }
+    }
+    return weightings;
+  }
+
+  void classify(const std::vector<weighting> &weightings, size_t window, const std::vector<uint8_t> &forced,
+                std::vector<uint8_t> &status) const {
+    for (size_t i = 0; i < n; ++i) {
+      bool in = true, out = true;
+      for (auto const &l : weightings) {
+        const size_t p = l.position[i];
+        in &= p + window < l.break_item;
+        out &= p > l.break_item + window;
+      }
+      status[i] = forced[i] ? 0 : in ? 1 : out ? 2 : 0;
+    }
+    // The fixed items must fit; otherwise the lightest-efficiency ones go back to the core.
+    T load = 0;
+    for (size_t i = 0; i < n; ++i) {
+      load += status[i] == 1 ? weight[i] : 0;
+    }
+    const auto &reference = weightings.back();
+    for (size_t p = n; p-- > 0 && load > capacity;) {
+      const size_t i = reference.order[p];
+      if (status[i] == 1) {
+        status[i] = 0;
+        load -= weight[i];
+      }
+    }
+  }
+
+  // Front of the core with the fixed items, merged with the known solutions
+  // `lower`. The core items go to the DP in decreasing efficiency for the
+  // weighting `reference`, and the states whose completions are all weakly
+  // dominated by known solutions are dropped: a reduced solution missed that
+  // way is weakly dominated by a point of the result.
+  std::vector<std::vector<T>> solve_core(const std::vector<uint8_t> &status, const weighting &reference,
+                                         const std::vector<std::vector<T>> &lower, double timeout) {
+    T fixed_weight = 0, fixed1 = 0, fixed2 = 0;
+    std::vector<T> points;
+    points.push_back(0);
+    size_t core = 0;
+    for (auto i : reference.order) {
+      if (status[i] == 1) {
+        fixed_weight += weight[i];
+        fixed1 += value1[i];
+        fixed2 += value2[i];
+      } else if (status[i] == 0) {
+        points.insert(points.end(), {value1[i], value2[i], weight[i]});
+        ++core;
+      }
+    }
+    points[0] = capacity - fixed_weight;
+    const auto problem = mobkp::problem<T>(core, 2, 1, std::move(points));
+    auto shifted = lower;
+    for (auto &p : shifted) {
+      p[0] -= fixed1;
+      p[1] -= fixed2;
+    }
+    auto pruner = bound_set_pruner<T>(problem, std::move(shifted));
+    auto inner = no_stats{};
+    auto stats = progress_stats(inner, counters);
+    auto hooks = dp_hooks<T>{};
+    hooks.prune = [&](size_t done, state_vector<T> &layer) { pruner.prune(done, layer); };
+    counters.items = core;
+    auto front = layered_dp<T>(problem, std::max(timeout, 0.0), stats, std::move(hooks));
+    for (auto &p : front) {
+      p[0] += fixed1;
+      p[1] += fixed2;
+    }
+    for (auto const &p : lower) {
+      presolve_detail::archive_insert(front, p);
+    }
+    return front;
+  }
+
+  // LP bound of the weighted knapsack over the items but the one at position
+  // q of the weighting, within capacity c.
+  T lp_bound(const weighting &l, size_t q, T c) const {
+    const auto &pw = l.prefix_weight;
+    const auto &pv = l.prefix_value;
+    const T wq = weight[l.order[q]];
+    const T vq = weighted(l, l.order[q]);
+    auto largest_within = [&](T limit) {
+      return static_cast<size_t>(std::upper_bound(pw.begin(), pw.end(), limit) - pw.begin() - 1);
+    };
+    size_t next = std::min(largest_within(c), q);
+    T used = pw[next], bound = pv[next];
+    if (next == q) {
+      // Every item before q fits, continue past it.
+      next = largest_within(c + wq);
+      used = pw[next] - wq;
+      bound = pv[next] - vq;
+    }
+    if (next < n && weight[l.order[next]] > 0) {
+      bound += weighted(l, l.order[next]) * (c - used) / weight[l.order[next]];
+    }
+    return bound;
+  }
+
+  // Whether every solution with item i flipped is strictly dominated by a point of the front.
+  bool provably_fixed(size_t i, bool fixed_in, const std::vector<std::vector<T>> &front,
+                      const std::vector<weighting> &weightings) const {
+    const T c = fixed_in ? capacity : capacity - weight[i];
+    if (c < 0) {
+      return true;  // the item cannot be added
+    }
+    std::vector<T> bound(weightings.size());
+    for (size_t w = 0; w < weightings.size(); ++w) {
+      const auto &l = weightings[w];
+      bound[w] = lp_bound(l, l.position[i], c) + (fixed_in ? 0 : weighted(l, i));
+    }
+    // Local upper points of the front, sorted by increasing first objective.
+    auto sorted = front;
+    std::sort(sorted.begin(), sorted.end());
+    for (size_t a = 0; a <= sorted.size(); ++a) {
+      const T u1 = a == 0 ? 0 : sorted[a - 1][0] + 1;
+      const T u2 = a == sorted.size() ? 0 : sorted[a][1] + 1;
+      bool separated = false;
+      for (size_t w = 0; w < weightings.size() && !separated; ++w) {
+        separated = weightings[w].l1 * u1 + weightings[w].l2 * u2 > bound[w];
+      }
+      if (!separated) {
+        return false;
+      }
+    }
+    return true;
+  }
+};
+
+template <typename T, typename Problem>
+std::vector<std::vector<T>> core_dp(const Problem &problem, double timeout, size_t threads, progress_counters &counters,
+                                    bool report = false) {
+  return core_solver<T>(problem, threads, counters, report).solve(timeout);
+}
+
+#endif  // CORE_HPP
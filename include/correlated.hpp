@@ -0,0 +1,158 @@
+#ifndef CORRELATED_HPP
+#define CORRELATED_HPP
+
+#include <algorithm>
+#include <cmath>
+#include <cstdint>
+#include <map>
+#include <mutex>
+#include <numeric>
+#include <random>
+#include <stdexcept>
+#include <utility>
+#include <vector>
+
+// Native version of the sampler of scripts/generator.R.
+//
+// The objective values follow a Gaussian copula whose Pearson correlation
+// 2 sin(pi/6 rho1) gives a Spearman correlation of rho1 between any two
+// objectives. The weight is built from the sum of the values and fresh noise
+// to have correlation rho2 with it, and is mapped through the empirical CDF
+// of at least `wsize` more weights drawn the same way. The steps, including
+// the final rescaling of the weights, are those of the R script, so both
+// produce the same distributions (not the same numbers, the generators
+// differ). The empirical CDF is a binary search in the sorted reference
+// weights, O((n + wsize) log(n + wsize)) instead of O(n wsize).
+
+// Lower Cholesky factor of the m x m matrix with unit diagonal and `rho`
+// elsewhere, kept for the next instance with the same m and correlation.
+const std::vector<double> &correlation_cholesky(int32_t m, double rho) {
+  static std::mutex mutex;
+  static std::map<std::pair<int32_t, double>, std::vector<double>> cache;
+  std::lock_guard<std::mutex> lock(mutex);
+  auto it = cache.find({m, rho});
+  if (it != cache.end()) {
+    return it->second;
+  }
+  std::vector<double> l(m * m, 0.0);
+  for (int32_t i = 0; i < m; ++i) {
+    for (int32_t j = 0; j <= i; ++j) {
+      double sum = i == j ? 1.0 : rho;
+      for (int32_t p = 0; p < j; ++p) {
+        sum -= l[i * m + p] * l[j * m + p];
+      }
+      if (i == j) {
+        if (sum <= 0.0) {
+          throw std::invalid_argument("The correlation matrix is not positive definite.");
+        }
+        l[i * m + i] = std::sqrt(sum);
+      } else {
+        l[i * m + j] = sum / l[j * m + j];
+      }
+    }
+  }
+  return cache.emplace(std::make_pair(m, rho), std::move(l)).first->second;
+}
+
+// Sample standard deviation, as R's sd.
+double sample_sd(const std::vector<double> &x) {
+  const double mean = std::accumulate(x.begin(), x.end(), 0.0) / x.size();
+  double ss = 0.0;
+  for (double v : x) {
+    ss += (v - mean) * (v - mean);
+  }
+  return std::sqrt(ss / (x.size() - 1));
+}
+
+// Weights correlated by rho2 with `wy`: the residuals of fresh noise regressed
+// on `wy` (lm(wx ~ wy)), combined with `wy`.
+template <typename Rng>
+void correlated_weights(const std::vector<double> &wy, double wy_mean, double wy_var, double wy_sd, double rho2,
+                        Rng &rng, std::vector<double> &out) {
+  const size_t n = wy.size();
+  auto normal = std::normal_distribution<double>(0.0, 1.0);
+  std::vector<double> wx(n);
+  for (auto &x : wx) {
+    x = normal(rng);
+  }
+  const double wx_mean = std::accumulate(wx.begin(), wx.end(), 0.0) / n;
+  double cov = 0.0;
+  for (size_t i = 0; i < n; ++i) {
+    cov += (wx[i] - wx_mean) * (wy[i] - wy_mean);
+  }
+  const double slope = wy_var > 0.0 ? cov / wy_var : 0.0;
+  for (size_t i = 0; i < n; ++i) {
+    wx[i] = wx[i] - wx_mean - slope * (wy[i] - wy_mean);
+  }
+  const double perp_sd = sample_sd(wx);
+  for (size_t i = 0; i < n; ++i) {
+    out.push_back(rho2 * perp_sd * wy[i] + wx[i] * wy_sd * std::sqrt(1 - rho2 * rho2));
+  }
+}
+
+// Points of a correlated instance in the layout of solve_mobkp: the capacity,
+// then the m values and the weight of each item, with coefficients in
+// [low, high] and the capacity `c` times the sum of the weights.
+std::vector<int64_t> sample_correlated_points(int32_t n, int32_t m, double rho1, double rho2, double c, uint64_t seed,
+                                              int64_t low = 1, int64_t high = 1000, size_t wsize = 1000) {
+  auto rng = std::mt19937_64(seed);
+  auto normal = std::normal_distribution<double>(0.0, 1.0);
+  const double pi = std::acos(-1.0);
+  rho1 = 2 * std::sin(pi / 6 * rho1);
+  rho2 = 2 * std::sin(pi / 6 * rho2);
+  const auto &l = correlation_cholesky(m, rho1);
+
+  auto scale = [&](double u) { return std::min(high, static_cast<int64_t>(std::floor(u * (high - low + 1) + low))); };
+
+  std::vector<int64_t> points(1 + n * (m + 1));
+  std::vector<double> z(m);
+  std::vector<double> wy(n, 0.0);
+  for (int32_t i = 0; i < n; ++i) {
+    for (auto &x : z) {
+      x = normal(rng);
+    }
+    for (int32_t j = 0; j < m; ++j) {
+      double x = 0.0;
+      for (int32_t p = 0; p <= j; ++p) {
+        x += l[j * m + p] * z[p];
+      }
+      const double u = 0.5 * std::erfc(-x / std::sqrt(2.0));  // pnorm
+      wy[i] += u;
+      points[1 + i * (m + 1) + j] = scale(u);
+    }
+  }
+
+  const double wy_mean = std::accumulate(wy.begin(), wy.end(), 0.0) / n;
+  double wy_var = 0.0;
+  for (double v : wy) {
+    wy_var += (v - wy_mean) * (v - wy_mean);
+  }
+  const double wy_sd = n > 1 ? std::sqrt(wy_var / (n - 1)) : 0.0;
+
+  std::vector<double> w;
+  std::vector<double> ws;
+  correlated_weights(wy, wy_mean, wy_var, wy_sd, rho2, rng, w);
+  while (ws.size() < wsize) {
+    correlated_weights(wy, wy_mean, wy_var, wy_sd, rho2, rng, ws);
+  }
+  const double ws_min = *std::min_element(ws.begin(), ws.end());
+  const double ws_max = *std::max_element(ws.begin(), ws.end());
+  std::sort(ws.begin(), ws.end());
+  for (auto &x : w) {
+    x = static_cast<double>(std::upper_bound(ws.begin(), ws.end(), x) - ws.begin()) / ws.size();
+  }
+  // As in the R script, the empirical CDF values are rescaled by the range
+  // of the raw reference weights together with themselves.
+  const double lo = std::min(ws_min, *std::min_element(w.begin(), w.end()));
+  const double hi = std::max(ws_max, *std::max_element(w.begin(), w.end()));
+  int64_t total_weight = 0;
+  for (int32_t i = 0; i < n; ++i) {
+    const int64_t weight = scale((w[i] - lo) / (hi - lo));
+    points[1 + i * (m + 1) + m] = weight;
+    total_weight += weight;
+  }
+  points[0] = static_cast<int64_t>(std::nearbyint(total_weight * c));  // R rounds half to even
+  return points;
+}
+
+#endif  // CORRELATED_HPP
@@ -0,0 +1,367 @@
+#ifndef DAEMON_HPP
+#define DAEMON_HPP
+
+#include <arpa/inet.h>
+#include <sys/socket.h>
+#include <sys/un.h>
+#include <unistd.h>
+
+#include <fmt/core.h>
+
+#include <algorithm>
+#include <atomic>
+#include <chrono>
+#include <condition_variable>
+#include <cstdlib>
+#include <cstring>
+#include <map>
+#include <memory>
+#include <mutex>
+#include <queue>
+#include <set>
+#include <sstream>
+#include <stdexcept>
+#include <string>
+#include <thread>
+#include <vector>
+
+#include <instance.hpp>
+#include <numa.hpp>
+#include <parser.hpp>
+#include <solver.hpp>
+
+// Long-running generation service.
+//
+// The daemon listens on a Unix domain socket and runs the jobs it receives on
+// a pool of worker threads kept warm between jobs. Every message, in both
+// directions, is a 4-byte big-endian length followed by that many bytes of
+// text. Requests:
+//
+//   generate [--priority=<p>] <options>  generate, solve and write to the library
+//   solve [--priority=<p>] <options>     generate and solve, the instance is sent back
+//   verify [--priority=<p>] <path>       solve a library instance and compare its front
+//   cancel <id>                          drop a queued job, stop a running native solve
+//   status                               queue length and running jobs
+//   shutdown                             stop accepting jobs and exit once idle
+//
+// where <options> are those of mobkp-instances. Jobs of higher priority run
+// first (default 0), in arrival order otherwise. Each job is answered with
+// "queued <id>", then "running <id>" and one of "done <id> ...",
+// "result <id>\n<instance>", "verified <id> ...", "cancelled <id>" or
+// "error <id> <message>".
+//
+// With NUMA placement the workers are spread evenly over the nodes, each
+// bound to its node, so a job and the states it allocates stay on one socket.
+
+bool write_fully(int fd, const char *data, size_t size) {
+  while (size > 0) {
+    const ssize_t written = ::send(fd, data, size, MSG_NOSIGNAL);
+    if (written <= 0) {
+      return false;
+    }
+    data += written;
+    size -= written;
+  }
+  return true;
+}
+
+bool read_fully(int fd, char *data, size_t size) {
+  while (size > 0) {
+    const ssize_t got = ::read(fd, data, size);
+    if (got <= 0) {
+      return false;
+    }
+    data += got;
+    size -= got;
+  }
+  return true;
+}
+
+class daemon_connection {
+ public:
+  explicit daemon_connection(int fd) : fd(fd) {}
+  ~daemon_connection() { ::close(fd); }
+  daemon_connection(const daemon_connection &) = delete;
+  daemon_connection &operator=(const daemon_connection &) = delete;
+
+  // Sends a framed message; workers and the reader thread share the socket.
+  bool send(const std::string &message) {
+    std::lock_guard<std::mutex> lock(mutex);
+    const uint32_t length = htonl(static_cast<uint32_t>(message.size()));
+    return write_fully(fd, reinterpret_cast<const char *>(&length), sizeof(length)) &&
+           write_fully(fd, message.data(), message.size());
+  }
+
+  bool receive(std::string &message) {
+    uint32_t length = 0;
+    if (!read_fully(fd, reinterpret_cast<char *>(&length), sizeof(length))) {
+      return false;
+    }
+    length = ntohl(length);
+    if (length > max_message) {
+      return false;
+    }
+    message.resize(length);
+    return read_fully(fd, message.data(), length);
+  }
+
+  void close_reads() { ::shutdown(fd, SHUT_RD); }
+
+  std::atomic<bool> closed = false;  // the client hung up, set by the reader thread
+
+ private:
+  static constexpr uint32_t max_message = 1 << 20;
+  int fd;
+  std::mutex mutex;
+};
+
+struct daemon_job {
+  uint64_t id = 0;
+  int32_t priority = 0;
+  std::string command;
+  std::string options;
+  std::shared_ptr<daemon_connection> connection;
+  progress_counters counters;
+};
+
+class generation_daemon {
+ public:
+  generation_daemon(const std::string &socket_path, size_t workers, bool numa) : socket_path(socket_path) {
+    listen_fd = ::socket(AF_UNIX, SOCK_STREAM, 0);
+    if (listen_fd < 0) {
+      throw std::runtime_error("Could not create socket: " + std::string(std::strerror(errno)));
+    }
+    auto address = sockaddr_un{};
+    address.sun_family = AF_UNIX;
+    if (socket_path.size() >= sizeof(address.sun_path)) {
+      throw std::invalid_argument("Socket path too long: " + socket_path);
+    }
+    std::strcpy(address.sun_path, socket_path.c_str());
+    ::unlink(socket_path.c_str());
+    if (::bind(listen_fd, reinterpret_cast<sockaddr *>(&address), sizeof(address)) != 0 ||
+        ::listen(listen_fd, 64) != 0) {
+      ::close(listen_fd);
+      throw std::runtime_error("Could not listen on " + socket_path + ": " + std::strerror(errno));
+    }
+    const auto nodes = numa ? numa_nodes() : std::vector<numa_node>{};
+    for (size_t w = 0; w < workers; ++w) {
+      if (nodes.size() > 1) {
+        pool.emplace_back([this, node = nodes[w % nodes.size()]]() {
+          if (!bind_thread_to_node(node)) {
+            fmt::print(stderr, "[daemon] could not bind a worker to node {}\n", node.id);
+          }
+          work();
+        });
+      } else {
+        pool.emplace_back([this]() { work(); });
+      }
+    }
+    placement = nodes.size() > 1 ? fmt::format(" over {} NUMA nodes", nodes.size()) : "";
+  }
+
+  ~generation_daemon() {
+    ::close(listen_fd);
+    ::unlink(socket_path.c_str());
+  }
+
+  // Accepts connections until a shutdown request, then waits for the running jobs.
+  void serve() {
+    fmt::print("[daemon] listening on {} with {} workers{}\n", socket_path, pool.size(), placement);
+    while (!stopping.load()) {
+      const int fd = ::accept(listen_fd, nullptr, nullptr);
+      if (fd < 0) {
+        continue;
+      }
+      auto connection = std::make_shared<daemon_connection>(fd);
+      std::lock_guard<std::mutex> lock(mutex);
+      reap_connections();
+      connections.emplace_back([this, connection]() { read_requests(connection); }, connection);
+    }
+    {
+      std::lock_guard<std::mutex> lock(mutex);
+      for (auto &c : connections) {
+        c.second->close_reads();
+      }
+    }
+    cv.notify_all();
+    for (auto &worker : pool) {
+      worker.join();
+    }
+    for (auto &c : connections) {
+      c.first.join();
+    }
+  }
+
+ private:
+  struct by_priority {
+    bool operator()(const std::shared_ptr<daemon_job> &a, const std::shared_ptr<daemon_job> &b) const {
+      return a->priority != b->priority ? a->priority < b->priority : a->id > b->id;
+    }
+  };
+
+  std::string socket_path;
+  std::string placement;
+  int listen_fd = -1;
+  std::atomic<bool> stopping = false;
+  std::mutex mutex;
+  std::condition_variable cv;
+  std::priority_queue<std::shared_ptr<daemon_job>, std::vector<std::shared_ptr<daemon_job>>, by_priority> queue;
+  std::map<uint64_t, std::shared_ptr<daemon_job>> active;  // queued and running jobs
+  size_t running = 0;
+  uint64_t next_id = 0;
+  std::vector<std::thread> pool;
+  std::vector<std::pair<std::thread, std::shared_ptr<daemon_connection>>> connections;
+  // generate_random_points draws from std::rand, so generation is serialized.
+  std::mutex generation_mutex;
+
+  void read_requests(std::shared_ptr<daemon_connection> connection) {
+    std::string request;
+    while (connection->receive(request)) {
+      handle(request, connection);
+    }
+    connection->closed.store(true);
+  }
+
+  // Joins the readers of the connections that hung up. Called with the lock held.
+  void reap_connections() {
+    for (auto it = connections.begin(); it != connections.end();) {
+      if (it->second->closed.load()) {
+        it->first.join();
+        it = connections.erase(it);
+      } else {
+        ++it;
+      }
+    }
+  }
+
+  // Answers a request. The reply is sent under the lock, so "queued" always
+  // reaches the client before the worker's "running".
+  void handle(const std::string &request, const std::shared_ptr<daemon_connection> &connection) {
+    std::istringstream ss(request);
+    std::string command;
+    ss >> command;
+    std::lock_guard<std::mutex> lock(mutex);
+    if (command == "generate" || command == "solve" || command == "verify") {
+      if (stopping.load()) {
+        connection->send("error - shutting down");
+        return;
+      }
+      auto job = std::make_shared<daemon_job>();
+      job->command = command;
+      job->connection = connection;
+      std::string token;
+      while (ss >> token) {
+        if (token.rfind("--priority=", 0) == 0) {
+          job->priority = std::atoi(token.c_str() + 11);
+        } else {
+          job->options += token + " ";
+        }
+      }
+      job->id = next_id++;
+      active[job->id] = job;
+      queue.push(job);
+      cv.notify_one();
+      connection->send(fmt::format("queued {}", job->id));
+    } else if (command == "cancel") {
+      uint64_t id = 0;
+      ss >> id;
+      auto it = active.find(id);
+      if (it == active.end()) {
+        connection->send(fmt::format("error {} unknown job", id));
+        return;
+      }
+      // Queued jobs are dropped when popped and running native solves stop at
+      // their next layer. A solve in a library engine cannot be stopped.
+      if (!it->second->counters.request_cancel()) {
+        connection->send(fmt::format("error {} not cancellable while running", id));
+        return;
+      }
+      connection->send(fmt::format("cancelling {}", id));
+    } else if (command == "status") {
+      connection->send(
+          fmt::format("status queued={} running={} workers={}", active.size() - running, running, pool.size()));
+    } else if (command == "shutdown") {
+      stopping.store(true);
+      ::shutdown(listen_fd, SHUT_RDWR);  // wakes up accept
+      cv.notify_all();
+      connection->send("shutting down");
+    } else {
+      connection->send("error - unknown request: " + command);
+    }
+  }
+
+  void work() {
+    while (true) {
+      std::shared_ptr<daemon_job> job;
+      {
+        std::unique_lock<std::mutex> lock(mutex);
+        cv.wait(lock, [this]() { return !queue.empty() || stopping.load(); });
+        if (queue.empty()) {
+          return;
+        }
+        job = queue.top();
+        queue.pop();
+        ++running;
+      }
+      std::string reply;
+      if (job->counters.cancelled.load()) {
+        reply = fmt::format("cancelled {}", job->id);
+      } else {
+        job->connection->send(fmt::format("running {}", job->id));
+        reply = run(*job);
+      }
+      {
+        std::lock_guard<std::mutex> lock(mutex);
+        active.erase(job->id);
+        --running;
+      }
+      job->connection->send(reply);
+    }
+  }
+
+  std::string run(daemon_job &job) {
+    const auto start = std::chrono::steady_clock::now();
+    auto seconds = [&]() { return std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count(); };
+    try {
+      if (job.command == "verify") {
+        const auto path = job.options.substr(0, job.options.find(' '));
+        const auto instance = read_instance(path);
+        auto config = solver_config{};
+        config.counters = &job.counters;
+        const auto front = solve_mobkp(config, instance.n, instance.m, instance.k, instance.points, instance.multiplicities).second;
+        auto expected = std::set<std::vector<int64_t>>(instance.front.begin(), instance.front.end());
+        auto computed = std::set<std::vector<int64_t>>(front.begin(), front.end());
+        const bool ok = expected == computed && computed.size() == front.size();
+        return fmt::format("verified {} {} front={}/{} time={:.3f}", job.id, ok ? "ok" : "mismatch", front.size(),
+                           instance.front.size(), seconds());
+      }
+
+      const auto args = parse_arguments_line(job.options);
+      std::vector<data_type> points;
+      {
+        std::lock_guard<std::mutex> lock(generation_mutex);
+        points = generate_points(*args);
+      }
+      auto config = solver_config::from_arguments(*args);
+      config.counters = &job.counters;
+      const auto multiplicities = generate_multiplicities(*args);
+      const auto problem_solutions =
+          solve_mobkp(config, args->get_n(), args->get_m(), args->get_k(), std::move(points), multiplicities);
+      if (job.command == "solve") {
+        std::ostringstream out;
+        write_instance(out, problem_solutions.first, problem_solutions.second, multiplicities);
+        return fmt::format("result {}\n{}", job.id, out.str());
+      }
+      write_solution(args->get_folder_path(), args->get_outfile(), problem_solutions.first, problem_solutions.second,
+                     multiplicities);
+      return fmt::format("done {} {}{} front={} time={:.3f}", job.id, args->get_folder_path(), args->get_outfile(),
+                         problem_solutions.second.size(), seconds());
+    } catch (const solve_cancelled &) {
+      return fmt::format("cancelled {}", job.id);
+    } catch (const std::exception &e) {
+      return fmt::format("error {} {}", job.id, e.what());
+    }
+  }
+};
+
+#endif  // DAEMON_HPP
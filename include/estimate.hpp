@@ -0,0 +1,171 @@
+#ifndef ESTIMATE_HPP
+#define ESTIMATE_HPP
+
+#include <algorithm>
+#include <chrono>
+#include <cmath>
+#include <cstdint>
+#include <numeric>
+#include <random>
+#include <vector>
+
+#include <mobkp/problem.hpp>
+
+#include <layered_dp.hpp>
+#include <stats.hpp>
+
+// Cheap prediction of the cost of a solve before committing to it.
+//
+// Random sub-instances of growing size k are drawn from the instance (with the
+// capacity set by the same weight factor) and solved with the native DP. The
+// front size, peak number of states and runtime are fitted with a power law
+// log(y) = a + b log(k) and extrapolated to the n items of the instance, with
+// a 95% prediction interval of the fit.
+
+struct estimate_value {
+  double value = 0.0;
+  double low = 0.0;
+  double high = 0.0;
+};
+
+struct solve_estimate {
+  estimate_value front_size;
+  estimate_value peak_states;
+  estimate_value memory_bytes;
+  estimate_value runtime;
+  size_t samples = 0;
+  size_t largest_sample = 0;
+};
+
+struct estimate_sample {
+  double items;
+  double front;
+  double peak_states;
+  double seconds;
+};
+
+// Least squares power law fit of (x, y) pairs evaluated at x0.
+estimate_value fit_power_law(const std::vector<double> &xs, const std::vector<double> &ys, double x0) {
+  const size_t count = xs.size();
+  if (count == 0) {
+    return {};
+  }
+  std::vector<double> lx(count), ly(count);
+  for (size_t i = 0; i < count; ++i) {
+    lx[i] = std::log(std::max(xs[i], 1e-12));
+    ly[i] = std::log(std::max(ys[i], 1e-12));
+  }
+  const double mx = std::accumulate(lx.begin(), lx.end(), 0.0) / count;
+  const double my = std::accumulate(ly.begin(), ly.end(), 0.0) / count;
+  double sxx = 0.0, sxy = 0.0;
+  for (size_t i = 0; i < count; ++i) {
+    sxx += (lx[i] - mx) * (lx[i] - mx);
+    sxy += (lx[i] - mx) * (ly[i] - my);
+  }
+  const double slope = sxx > 0.0 ? sxy / sxx : 0.0;
+  const double intercept = my - slope * mx;
+  double sse = 0.0;
+  for (size_t i = 0; i < count; ++i) {
+    const double r = ly[i] - (intercept + slope * lx[i]);
+    sse += r * r;
+  }
+  const double lx0 = std::log(x0);
+  const double prediction = intercept + slope * lx0;
+  const double s = count > 2 ? std::sqrt(sse / (count - 2)) : 0.0;
+  const double se = s * std::sqrt(1.0 + 1.0 / count + (sxx > 0.0 ? (lx0 - mx) * (lx0 - mx) / sxx : 0.0));
+  return {std::exp(prediction), std::exp(prediction - 1.96 * se), std::exp(prediction + 1.96 * se)};
+}
+
+// `points` is laid out as for solve_mobkp: the k capacities, then the m values
+// and k weights of each item. `budget` bounds the time spent sampling in seconds.
+template <typename T>
+solve_estimate estimate_solve(int32_t n, int32_t m, int32_t k, const std::vector<T> &points, double weight_factor,
+                              double budget, uint64_t seed) {
+  const auto start = std::chrono::steady_clock::now();
+  auto elapsed = [&]() { return std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count(); };
+  const size_t stride = m + k;
+  const size_t replicates = 3;
+  std::mt19937_64 rng(seed);
+  std::vector<size_t> order(n);
+  std::iota(order.begin(), order.end(), 0);
+
+  std::vector<estimate_sample> samples;
+  double last_seconds = 0.0;
+  bool done = false;
+  // Expected time of a sample of `items` items: the runtime fitted to the
+  // samples once they cover two sizes, and until then the time of the last
+  // sample scaled quadratically with the size.
+  auto expected_seconds = [&](size_t items) {
+    std::vector<double> xs, seconds;
+    for (auto const &s : samples) {
+      xs.push_back(s.items);
+      seconds.push_back(s.seconds);
+    }
+    if (xs.front() == xs.back()) {
+      const double ratio = items / xs.back();
+      return samples.back().seconds * ratio * ratio;
+    }
+    return fit_power_law(xs, seconds, items).value;
+  };
+  for (size_t items = std::min<size_t>(8, n); !done;) {
+    for (size_t r = 0; r < replicates && !done; ++r) {
+      // Stop before a sample that is expected to overrun the budget.
+      const double remaining = budget - elapsed();
+      if (remaining <= 0.0 || (!samples.empty() && expected_seconds(items) > remaining)) {
+        done = true;
+        break;
+      }
+      std::shuffle(order.begin(), order.end(), rng);
+      std::vector<T> sub(k + items * stride);
+      std::vector<T> total_weight(k, 0);
+      for (size_t i = 0; i < items; ++i) {
+        std::copy_n(points.begin() + k + order[i] * stride, stride, sub.begin() + k + i * stride);
+        for (int32_t c = 0; c < k; ++c) {
+          total_weight[c] += sub[k + i * stride + m + c];
+        }
+      }
+      for (int32_t c = 0; c < k; ++c) {
+        sub[c] = static_cast<T>(std::round(total_weight[c] * weight_factor));
+      }
+
+      const auto problem = mobkp::problem<T>(items, m, k, std::move(sub));
+      auto stats = layer_stats{};
+      const auto sample_start = elapsed();
+      const auto front = layered_dp<T>(problem, remaining, stats);
+      last_seconds = elapsed() - sample_start;
+      if (stats.layers.size() < items) {
+        done = true;  // timed out, the sample is incomplete
+        break;
+      }
+      size_t peak = 1;
+      for (auto const &layer : stats.layers) {
+        peak = std::max(peak, layer.states_after);
+      }
+      samples.push_back({static_cast<double>(items), static_cast<double>(front.size()), static_cast<double>(peak),
+                         last_seconds});
+    }
+    done |= items == static_cast<size_t>(n);
+    items = std::min<size_t>(n, std::max(items + 2, items * 5 / 4));
+  }
+
+  auto estimate = solve_estimate{};
+  estimate.samples = samples.size();
+  std::vector<double> xs, fronts, peaks, seconds;
+  for (auto const &s : samples) {
+    xs.push_back(s.items);
+    fronts.push_back(s.front);
+    peaks.push_back(s.peak_states);
+    seconds.push_back(s.seconds);
+    estimate.largest_sample = std::max(estimate.largest_sample, static_cast<size_t>(s.items));
+  }
+  estimate.front_size = fit_power_law(xs, fronts, n);
+  estimate.peak_states = fit_power_law(xs, peaks, n);
+  estimate.runtime = fit_power_law(xs, seconds, n);
+  // The layered DP keeps the layer, its shifted copy and their merge.
+  const double state_bytes = 3.0 * stride * sizeof(T);
+  estimate.memory_bytes = {estimate.peak_states.value * state_bytes, estimate.peak_states.low * state_bytes,
+                           estimate.peak_states.high * state_bytes};
+  return estimate;
+}
+
+#endif  // ESTIMATE_HPP
@@ -0,0 +1,513 @@
+#ifndef EXTERNAL_DP_HPP
+#define EXTERNAL_DP_HPP
+
+#include <fcntl.h>
+#include <unistd.h>
+
+#include <algorithm>
+#include <atomic>
+#include <chrono>
+#include <cstdlib>
+#include <cstring>
+#include <filesystem>
+#include <functional>
+#include <memory>
+#include <numeric>
+#include <queue>
+#include <stdexcept>
+#include <string>
+#include <vector>
+
+#include <pages.hpp>
+#include <state.hpp>
+#include <stats.hpp>
+#include <trace.hpp>
+
+// External-memory dynamic programming for the MOBKP.
+//
+// Each DP layer is a file of fixed-width records (m objective values followed
+// by k weights) kept sorted by (sum of weights asc, weights asc, objectives
+// desc). With this order a state can only be dominated by states that come
+// before it, and adding an item to every state preserves the order. A layer
+// is extended by k-way merging the layer with its shifted copies and the
+// result is filtered with a sort-filter-skyline pass whose window is bounded
+// by the configured memory, spilling the undecided states to an overflow file.
+
+struct external_dp_config {
+  std::string directory;                    // where the layer files are spilled
+  size_t memory_bytes = size_t(1) << 30;    // memory for the dominance window and sort runs
+  size_t buffer_bytes = size_t(8) << 20;    // size of each sequential I/O buffer
+  size_t items_per_pass = 1;                // items merged per pass over a layer (2^items streams)
+};
+
+class aligned_buffer {
+ public:
+  static constexpr size_t alignment = 4096;
+
+  explicit aligned_buffer(size_t bytes) : bytes(bytes) {
+    if (posix_memalign(&data, alignment, std::max(bytes, alignment)) != 0) {
+      throw std::bad_alloc();
+    }
+  }
+  ~aligned_buffer() { free(data); }
+  aligned_buffer(const aligned_buffer &) = delete;
+  aligned_buffer &operator=(const aligned_buffer &) = delete;
+
+  char *get() const { return static_cast<char *>(data); }
+  size_t size() const { return bytes; }
+
+ private:
+  void *data = nullptr;
+  size_t bytes;
+};
+
+// Sequential writer of fixed-width records through a large aligned buffer.
+template <typename T>
+class record_writer {
+ public:
+  record_writer(const std::string &path, size_t width, size_t buffer_bytes)
+      : path(path), record_bytes(width * sizeof(T)), buffer(records_per_buffer(width, buffer_bytes) * width * sizeof(T)) {
+    fd = ::open(path.c_str(), O_WRONLY | O_CREAT | O_TRUNC, 0644);
+    if (fd < 0) {
+      throw std::runtime_error("Could not open file for writing: " + path);
+    }
+  }
+  ~record_writer() {
+    if (fd >= 0) {
+      ::close(fd);
+    }
+  }
+  record_writer(const record_writer &) = delete;
+  record_writer &operator=(const record_writer &) = delete;
+
+  void push(const T *record) {
+    if (used + record_bytes > buffer.size()) {
+      flush();
+    }
+    std::memcpy(buffer.get() + used, record, record_bytes);
+    used += record_bytes;
+    ++records;
+  }
+
+  void close() {
+    flush();
+    if (fd >= 0 && ::close(fd) != 0) {
+      throw std::runtime_error("Could not close file: " + path);
+    }
+    fd = -1;
+  }
+
+  size_t count() const { return records; }
+
+ private:
+  std::string path;
+  size_t record_bytes;
+  aligned_buffer buffer;
+  size_t used = 0;
+  size_t records = 0;
+  int fd = -1;
+
+  void flush() {
+    size_t done = 0;
+    while (done < used) {
+      ssize_t ret = ::write(fd, buffer.get() + done, used - done);
+      if (ret < 0) {
+        throw std::runtime_error("Could not write to file: " + path);
+      }
+      done += static_cast<size_t>(ret);
+    }
+    used = 0;
+  }
+
+  static size_t records_per_buffer(size_t width, size_t buffer_bytes) {
+    return std::max<size_t>(1, buffer_bytes / (width * sizeof(T)));
+  }
+};
+
+// Sequential reader of fixed-width records through a large aligned buffer.
+template <typename T>
+class record_reader {
+ public:
+  record_reader(const std::string &path, size_t width, size_t buffer_bytes)
+      : path(path),
+        width(width),
+        record_bytes(width * sizeof(T)),
+        buffer(std::max<size_t>(1, buffer_bytes / (width * sizeof(T))) * width * sizeof(T)) {
+    fd = ::open(path.c_str(), O_RDONLY);
+    if (fd < 0) {
+      throw std::runtime_error("Could not open file for reading: " + path);
+    }
+#ifdef POSIX_FADV_SEQUENTIAL
+    posix_fadvise(fd, 0, 0, POSIX_FADV_SEQUENTIAL);
+#endif
+  }
+  ~record_reader() { ::close(fd); }
+  record_reader(const record_reader &) = delete;
+  record_reader &operator=(const record_reader &) = delete;
+
+  // Returns a pointer to the next record, or nullptr at the end of the file.
+  const T *next() {
+    if (pos == used) {
+      fill();
+      if (used == 0) {
+        return nullptr;
+      }
+    }
+    const T *record = reinterpret_cast<const T *>(buffer.get() + pos);
+    pos += record_bytes;
+    return record;
+  }
+
+  size_t record_width() const { return width; }
+
+ private:
+  std::string path;
+  size_t width;
+  size_t record_bytes;
+  aligned_buffer buffer;
+  size_t used = 0;
+  size_t pos = 0;
+  int fd = -1;
+
+  void fill() {
+    used = 0;
+    pos = 0;
+    while (used < buffer.size()) {
+      ssize_t ret = ::read(fd, buffer.get() + used, buffer.size() - used);
+      if (ret < 0) {
+        throw std::runtime_error("Could not read from file: " + path);
+      }
+      if (ret == 0) {
+        break;
+      }
+      used += static_cast<size_t>(ret);
+    }
+    if (used % record_bytes != 0) {
+      throw std::runtime_error("Truncated record in file: " + path);
+    }
+  }
+};
+
+// Removes the spill directory of a solve when it goes out of scope.
+class spill_directory {
+ public:
+  explicit spill_directory(const std::string &parent) {
+    static std::atomic<size_t> counter = 0;
+    path = std::filesystem::path(parent) / ("mobkp-" + std::to_string(::getpid()) + "-" + std::to_string(counter++));
+    std::filesystem::create_directories(path);
+  }
+  ~spill_directory() {
+    std::error_code ec;
+    std::filesystem::remove_all(path, ec);
+  }
+  spill_directory(const spill_directory &) = delete;
+  spill_directory &operator=(const spill_directory &) = delete;
+
+  std::string file(const std::string &name) const { return (path / name).string(); }
+
+ private:
+  std::filesystem::path path;
+};
+
+// Sort-filter-skyline pass over a stream sorted so that dominators come first.
+// States kept in the window are final and are written to `out` straight away;
+// undecided states that do not fit in the window go to an overflow file and are
+// filtered in a further pass. `next` yields the sorted input (nullptr at the end).
+template <typename T, typename Next, typename Dominates, typename Stats = no_stats>
+void bounded_filter(Next &&next, Dominates &&dominates, record_writer<T> &out, const spill_directory &dir, size_t width,
+                    size_t window_records, size_t buffer_bytes, Stats &&stats = Stats{}) {
+  MOBKP_TRACE_SPAN("filter", "dp");
+  state_vector<T> window;
+  size_t pass = 0;
+  std::string overflow_path;
+  std::unique_ptr<record_reader<T>> overflow_in;
+  auto source = [&]() -> const T * { return overflow_in ? overflow_in->next() : next(); };
+
+  while (true) {
+    const std::string spill_path = dir.file("overflow-" + std::to_string(pass));
+    std::unique_ptr<record_writer<T>> overflow_out;
+    window.clear();
+    while (const T *s = source()) {
+      bool dominated = false;
+      size_t i = 0;
+      for (; i < window.size(); i += width) {
+        if (dominates(window.data() + i, s)) {
+          dominated = true;
+          break;
+        }
+      }
+      stats.dominance_tests(std::min(i, window.size()) / width + dominated);
+      if (dominated) {
+        continue;
+      }
+      if (window.size() < window_records * width) {
+        window.insert(window.end(), s, s + width);
+        out.push(s);
+      } else {
+        if (!overflow_out) {
+          overflow_out = std::make_unique<record_writer<T>>(spill_path, width, buffer_bytes);
+        }
+        overflow_out->push(s);
+      }
+    }
+    overflow_in.reset();
+    if (!overflow_path.empty()) {
+      std::filesystem::remove(overflow_path);
+      overflow_path.clear();
+    }
+    if (!overflow_out) {
+      break;
+    }
+    overflow_out->close();
+    overflow_path = spill_path;
+    overflow_in = std::make_unique<record_reader<T>>(overflow_path, width, buffer_bytes);
+    ++pass;
+  }
+}
+
+// Sorts a record file with bounded memory: sorted runs of `run_records` records
+// are spilled and then combined with a k-way merge that drops duplicates.
+template <typename T, typename Before>
+void external_sort(const std::string &in_path, const std::string &out_path, const spill_directory &dir, size_t width,
+                   size_t run_records, size_t buffer_bytes, Before &&before) {
+  MOBKP_TRACE_SPAN("external_sort", "dp");
+  std::vector<std::string> runs;
+  {
+    auto in = record_reader<T>(in_path, width, buffer_bytes);
+    state_vector<T> chunk;
+    std::vector<size_t> order;
+    chunk.reserve(run_records * width);
+    const T *s = in.next();
+    while (s != nullptr) {
+      chunk.clear();
+      for (; s != nullptr && chunk.size() < run_records * width; s = in.next()) {
+        chunk.insert(chunk.end(), s, s + width);
+      }
+      order.resize(chunk.size() / width);
+      std::iota(order.begin(), order.end(), 0);
+      std::sort(order.begin(), order.end(),
+                [&](size_t a, size_t b) { return before(chunk.data() + a * width, chunk.data() + b * width); });
+      runs.push_back(dir.file("run-" + std::to_string(runs.size())));
+      auto run = record_writer<T>(runs.back(), width, buffer_bytes);
+      for (auto i : order) {
+        run.push(chunk.data() + i * width);
+      }
+      run.close();
+    }
+  }
+
+  std::vector<std::unique_ptr<record_reader<T>>> readers;
+  for (auto const &run : runs) {
+    readers.push_back(std::make_unique<record_reader<T>>(run, width, buffer_bytes));
+  }
+  std::vector<const T *> heads(readers.size());
+  auto cmp = [&](size_t a, size_t b) { return before(heads[b], heads[a]); };
+  std::priority_queue<size_t, std::vector<size_t>, decltype(cmp)> heap(cmp);
+  for (size_t r = 0; r < readers.size(); ++r) {
+    if ((heads[r] = readers[r]->next()) != nullptr) {
+      heap.push(r);
+    }
+  }
+  auto out = record_writer<T>(out_path, width, buffer_bytes);
+  std::vector<T> last;
+  while (!heap.empty()) {
+    size_t r = heap.top();
+    heap.pop();
+    if (last.empty() || !std::equal(last.begin(), last.end(), heads[r])) {
+      out.push(heads[r]);
+      last.assign(heads[r], heads[r] + width);
+    }
+    if ((heads[r] = readers[r]->next()) != nullptr) {
+      heap.push(r);
+    }
+  }
+  out.close();
+  readers.clear();
+  for (auto const &run : runs) {
+    std::filesystem::remove(run);
+  }
+}
+
+template <typename T, typename Problem, typename Stats = no_stats>
+std::vector<std::vector<T>> external_dp(const Problem &problem, const external_dp_config &config, double timeout,
+                                        Stats &stats) {
+  const auto start = std::chrono::steady_clock::now();
+  const size_t n = problem.num_items();
+  const size_t m = problem.num_objectives();
+  const size_t k = problem.num_constraints();
+  const auto layout = state_layout<T>{m, k};
+  const size_t width = layout.width();
+  const size_t record_bytes = width * sizeof(T);
+  const size_t batch = std::max<size_t>(1, std::min<size_t>(config.items_per_pass, 16));
+
+  // The merge keeps one buffer per stream plus the output and overflow buffers,
+  // whatever is left of the memory budget holds the dominance window.
+  const size_t io_bytes = ((size_t(1) << batch) + 3) * config.buffer_bytes;
+  if (config.memory_bytes <= io_bytes) {
+    throw std::invalid_argument("External memory budget is too small for the I/O buffers.");
+  }
+  const size_t window_records = std::max<size_t>(1, (config.memory_bytes - io_bytes) / record_bytes);
+
+  T capacity_sum = 0;
+  std::vector<T> capacity(k);
+  for (size_t j = 0; j < k; ++j) {
+    capacity[j] = problem.weight_capacity(j);
+    capacity_sum += capacity[j];
+  }
+
+  auto dir = spill_directory(config.directory);
+  size_t layer_id = 0;
+  size_t layer_states = 1;
+  std::string layer_path = dir.file("layer-0");
+  {
+    auto out = record_writer<T>(layer_path, width, config.buffer_bytes);
+    auto empty = std::vector<T>(width, 0);
+    out.push(empty.data());
+    out.close();
+  }
+
+  for (size_t i = 0; i < n; i += batch) {
+    if (std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count() > timeout) {
+      break;
+    }
+    MOBKP_TRACE_SPAN("layer", "dp");
+    const size_t items = std::min(batch, n - i);
+    const size_t streams = size_t(1) << items;
+    stats.begin_layer(i, layer_states);
+
+    // The shift of stream s is the sum of the items selected by the bits of s.
+    std::vector<T> shifts(streams * width, 0);
+    for (size_t s = 1; s < streams; ++s) {
+      for (size_t b = 0; b < items; ++b) {
+        if (s & (size_t(1) << b)) {
+          auto values = problem.item_values(i + b);
+          auto weights = problem.item_weights(i + b);
+          for (size_t j = 0; j < m; ++j) {
+            shifts[s * width + j] += values[j];
+          }
+          for (size_t j = 0; j < k; ++j) {
+            shifts[s * width + m + j] += weights[j];
+          }
+        }
+      }
+    }
+
+    std::vector<std::unique_ptr<record_reader<T>>> readers;
+    std::vector<std::vector<T>> heads(streams, std::vector<T>(width));
+    std::vector<size_t> consumed(streams, 0);
+    for (size_t s = 0; s < streams; ++s) {
+      readers.push_back(std::make_unique<record_reader<T>>(layer_path, width, config.buffer_bytes));
+    }
+
+    // Advances stream s to its next feasible shifted state.
+    auto advance = [&](size_t s) {
+      const T *shift = shifts.data() + s * width;
+      const T shift_sum = layout.weight_sum(shift);
+      while (const T *r = readers[s]->next()) {
+        ++consumed[s];
+        if (layout.weight_sum(r) + shift_sum > capacity_sum) {
+          // States are sorted by total weight, none further fits.
+          stats.capacity_rejections(layer_states - consumed[s] + 1);
+          break;
+        }
+        bool feasible = true;
+        for (size_t j = 0; j < k; ++j) {
+          feasible &= r[m + j] + shift[m + j] <= capacity[j];
+        }
+        if (!feasible) {
+          stats.capacity_rejection();
+        } else {
+          if (s != 0) {
+            stats.candidate();
+          }
+          for (size_t j = 0; j < width; ++j) {
+            heads[s][j] = r[j] + shift[j];
+          }
+          return true;
+        }
+      }
+      return false;
+    };
+
+    auto cmp = [&](size_t a, size_t b) { return layout.before(heads[b].data(), heads[a].data()); };
+    std::priority_queue<size_t, std::vector<size_t>, decltype(cmp)> heap(cmp);
+    for (size_t s = 0; s < streams; ++s) {
+      if (advance(s)) {
+        heap.push(s);
+      }
+    }
+    std::vector<T> current(width);
+    std::vector<T> last;
+    auto next = [&]() -> const T * {
+      while (!heap.empty()) {
+        size_t s = heap.top();
+        heap.pop();
+        current = heads[s];
+        if (advance(s)) {
+          heap.push(s);
+        }
+        if (last.empty() || last != current) {
+          last = current;
+          return current.data();
+        }
+      }
+      return nullptr;
+    };
+
+    const std::string next_path = dir.file("layer-" + std::to_string(++layer_id));
+    auto out = record_writer<T>(next_path, width, config.buffer_bytes);
+    bounded_filter<T>(next, [&](const T *a, const T *b) { return layout.dominates(a, b); }, out, dir, width,
+                      window_records, config.buffer_bytes, stats);
+    out.close();
+    layer_states = out.count();
+    stats.end_layer(layer_states, std::min(window_records, layer_states) * record_bytes + io_bytes);
+    readers.clear();
+    std::filesystem::remove(layer_path);
+    layer_path = next_path;
+  }
+
+  // Final front: order by objectives only and filter ignoring the weights.
+  auto objectives_before = [&](const T *a, const T *b) {
+    for (size_t j = 0; j < m; ++j) {
+      if (a[j] != b[j]) {
+        return a[j] > b[j];
+      }
+    }
+    return false;
+  };
+  auto objectives_dominate = [&](const T *a, const T *b) {
+    for (size_t j = 0; j < m; ++j) {
+      if (a[j] < b[j]) {
+        return false;
+      }
+    }
+    return true;
+  };
+  {
+    // Projected records keep only the objective values.
+    auto in = record_reader<T>(layer_path, width, config.buffer_bytes);
+    auto out = record_writer<T>(dir.file("projected"), m, config.buffer_bytes);
+    while (const T *s = in.next()) {
+      out.push(s);
+    }
+    out.close();
+  }
+  const size_t run_records = std::max<size_t>(1, (config.memory_bytes - io_bytes) / (m * sizeof(T)));
+  external_sort<T>(dir.file("projected"), dir.file("sorted"), dir, m, run_records, config.buffer_bytes,
+                   objectives_before);
+  {
+    auto in = record_reader<T>(dir.file("sorted"), m, config.buffer_bytes);
+    auto out = record_writer<T>(dir.file("front"), m, config.buffer_bytes);
+    bounded_filter<T>([&]() { return in.next(); }, objectives_dominate, out, dir, m, run_records, config.buffer_bytes);
+    out.close();
+  }
+
+  std::vector<std::vector<T>> front;
+  auto in = record_reader<T>(dir.file("front"), m, config.buffer_bytes);
+  while (const T *s = in.next()) {
+    front.emplace_back(s, s + m);
+  }
+  return front;
+}
+
+#endif  // EXTERNAL_DP_HPP
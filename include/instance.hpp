@@ -0,0 +1,79 @@
+#ifndef INSTANCE_HPP
+#define INSTANCE_HPP
+
+#include <cstdint>
+#include <fstream>
+#include <sstream>
+#include <stdexcept>
+#include <string>
+#include <vector>
+
+// An instance of the library as stored in `instances/`, see instances/README.md.
+// Multi-constraint instances have a "n m k" header, k capacities and k weights
+// before the values of each item. Bounded instances have a "n m k U" header
+// and the multiplicity of each item before its weights.
+struct instance_file {
+  int32_t n = 0;
+  int32_t m = 0;
+  int32_t k = 1;
+  std::vector<int64_t> points;              // k capacities first, then the m values and k weights of each item
+  std::vector<int64_t> multiplicities;      // copies of each item, empty for 0/1 instances
+  std::vector<std::vector<int64_t>> front;  // non-dominated points stored with the instance
+};
+
+instance_file read_instance(const std::string &file_path) {
+  auto fin = std::ifstream(file_path);
+  if (!fin.is_open()) {
+    throw std::runtime_error("Could not open file " + file_path);
+  }
+
+  auto instance = instance_file{};
+  std::string header;
+  std::getline(fin, header);
+  auto header_stream = std::istringstream(header);
+  header_stream >> instance.n >> instance.m;
+  int64_t max_multiplicity = 0;
+  if (!(header_stream >> instance.k)) {
+    instance.k = 1;
+  } else if (header_stream >> max_multiplicity) {
+    instance.multiplicities.resize(instance.n);
+  }
+  if (instance.n <= 0 || instance.m <= 1 || instance.k <= 0) {
+    throw std::runtime_error("Invalid header in file " + file_path);
+  }
+  const int32_t n = instance.n;
+  const int32_t m = instance.m;
+  const int32_t k = instance.k;
+
+  instance.points.resize(k + n * (m + k));
+  for (int c = 0; c < k; c++) {
+    fin >> instance.points[c];
+  }
+  for (int i = 0; i < n; i++) {
+    int64_t *item = instance.points.data() + k + i * (m + k);
+    if (!instance.multiplicities.empty()) {
+      fin >> instance.multiplicities[i];
+    }
+    for (int c = 0; c < k; c++) {
+      fin >> item[m + c];
+    }
+    for (int j = 0; j < m; j++) {
+      fin >> item[j];
+    }
+  }
+
+  size_t nd = 0;
+  fin >> nd;
+  instance.front.resize(nd, std::vector<int64_t>(m));
+  for (auto &p : instance.front) {
+    for (auto &v : p) {
+      fin >> v;
+    }
+  }
+  if (!fin) {
+    throw std::runtime_error("Truncated instance in file " + file_path);
+  }
+  return instance;
+}
+
+#endif  // INSTANCE_HPP
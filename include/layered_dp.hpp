@@ -0,0 +1,383 @@
+#ifndef LAYERED_DP_HPP
+#define LAYERED_DP_HPP
+
+#include <algorithm>
+#include <chrono>
+#include <cstdint>
+#include <functional>
+#include <iterator>
+#include <limits>
+#include <numeric>
+#include <utility>
+#include <vector>
+
+#include <pages.hpp>
+#include <state.hpp>
+#include <stats.hpp>
+#include <trace.hpp>
+
+// In-memory Nemhauser-Ullmann dynamic programming for the MOBKP.
+//
+// A layer holds the states (m objective values followed by k weights) that are
+// not dominated after the first i items, sorted in the order of
+// `state_layout::before`. Adding item i keeps the order, so the next layer is
+// a merge of the layer with its shifted feasible copy, and a dominated state
+// always comes after a state dominating it.
+
+namespace layered_detail {
+
+// Flags the states dominated by an earlier state on the first three columns
+// of `coords` (three values to maximize per state, in the merged order).
+// Divide and conquer over the order: after both halves are done and sorted by
+// decreasing first column, the earlier half is swept into a Fenwick tree of
+// the best third column by rank of the second, and each later state asks
+// whether a state with no less first and second column has no less third.
+// O(L log^2 L) for L states. Returns the number of tree queries.
+template <typename T>
+class dominance_sweep {
+ public:
+  dominance_sweep(const std::vector<T> &coords, std::vector<uint8_t> &flagged)
+      : coords(coords), flagged(flagged), ids(coords.size() / 3), buffer(ids.size()) {
+    const size_t states = ids.size();
+    std::iota(ids.begin(), ids.end(), 0);
+    // Ranks of the second column in decreasing order, so "no less" is a prefix.
+    std::vector<T> seconds(states);
+    for (size_t id = 0; id < states; ++id) {
+      seconds[id] = coords[id * 3 + 1];
+    }
+    std::sort(seconds.begin(), seconds.end(), std::greater<>());
+    seconds.erase(std::unique(seconds.begin(), seconds.end()), seconds.end());
+    rank.resize(states);
+    for (size_t id = 0; id < states; ++id) {
+      rank[id] = std::lower_bound(seconds.begin(), seconds.end(), coords[id * 3 + 1], std::greater<>()) - seconds.begin();
+    }
+    tree.assign(seconds.size() + 1, std::numeric_limits<T>::lowest());
+  }
+
+  size_t run() {
+    if (!ids.empty()) {
+      solve(0, ids.size());
+    }
+    return queries;
+  }
+
+ private:
+  const std::vector<T> &coords;
+  std::vector<uint8_t> &flagged;
+  std::vector<size_t> ids, buffer, rank;
+  std::vector<T> tree;
+  size_t queries = 0;
+
+  T column(size_t id, size_t c) const { return coords[id * 3 + c]; }
+
+  void update(size_t r, T value) {
+    for (size_t i = r + 1; i < tree.size(); i += i & (~i + 1)) {
+      tree[i] = std::max(tree[i], value);
+    }
+  }
+  void reset(size_t r) {
+    for (size_t i = r + 1; i < tree.size(); i += i & (~i + 1)) {
+      tree[i] = std::numeric_limits<T>::lowest();
+    }
+  }
+  T best(size_t r) const {
+    T value = std::numeric_limits<T>::lowest();
+    for (size_t i = r + 1; i > 0; i -= i & (~i + 1)) {
+      value = std::max(value, tree[i]);
+    }
+    return value;
+  }
+
+  // Leaves ids[lo, hi) sorted by decreasing first column.
+  void solve(size_t lo, size_t hi) {
+    if (hi - lo == 1) {
+      return;
+    }
+    const size_t mid = lo + (hi - lo) / 2;
+    solve(lo, mid);
+    solve(mid, hi);
+    size_t l = lo;
+    for (size_t r = mid; r < hi; ++r) {
+      const size_t id = ids[r];
+      while (l < mid && column(ids[l], 0) >= column(id, 0)) {
+        update(rank[ids[l]], column(ids[l], 2));
+        ++l;
+      }
+      if (!flagged[id]) {
+        ++queries;
+        flagged[id] = best(rank[id]) >= column(id, 2);
+      }
+    }
+    for (size_t i = lo; i < l; ++i) {
+      reset(rank[ids[i]]);
+    }
+    auto by_first = [&](size_t a, size_t b) { return column(a, 0) > column(b, 0); };
+    std::merge(ids.begin() + lo, ids.begin() + mid, ids.begin() + mid, ids.begin() + hi, buffer.begin() + lo, by_first);
+    std::copy(buffer.begin() + lo, buffer.begin() + hi, ids.begin() + lo);
+  }
+};
+
+}  // namespace layered_detail
+
+// Removes the states of `merged` dominated by other states.
+// `from_shifted[s]` tells whether state s comes from the shifted copy.
+//
+// A dominating state always comes first in the merged order, so a state is
+// dominated exactly when an earlier one has no less of every value and no more
+// of every weight. With one constraint the order already sorts by weight and
+// only the values are compared. Dominance is transitive, so it does not matter
+// whether that earlier state is kept. With two values and one constraint a
+// staircase of the best second value by first value decides each state by a
+// binary search. Otherwise the columns (the values, then the negated weights with
+// several constraints) go through a dominance sweep on their first three; it is
+// exact for three columns, and beyond that the states it flags are checked
+// against the kept states of the other origin, as both inputs are free of
+// dominated states.
+template <typename T, typename Stats>
+void filter_merged(const state_layout<T> &layout, const state_vector<T> &merged, const std::vector<uint8_t> &from_shifted,
+                   state_vector<T> &out, Stats &stats) {
+  MOBKP_TRACE_SPAN("filter", "dp");
+  const size_t width = layout.width();
+  const size_t states = merged.size() / width;
+  const size_t columns = layout.m + (layout.k > 1 ? layout.k : 0);
+  out.clear();
+
+  if (columns == 2) {
+    // Non-dominated (first, second) values of the states so far, by increasing
+    // first and so decreasing second value. It holds at most a front, so a
+    // sorted vector beats a tree.
+    std::vector<std::pair<T, T>> staircase;
+    auto by_first = [](const std::pair<T, T> &step, T first) { return step.first < first; };
+    for (size_t s = 0; s < merged.size(); s += width) {
+      const T *state = merged.data() + s;
+      auto above = std::lower_bound(staircase.begin(), staircase.end(), state[0], by_first);
+      if (above != staircase.end() && above->second >= state[1]) {
+        continue;
+      }
+      // Replace the steps the state covers, just below its first value.
+      auto first = above;
+      while (first != staircase.begin() && std::prev(first)->second <= state[1]) {
+        --first;
+      }
+      if (first == above) {
+        staircase.insert(above, {state[0], state[1]});
+      } else {
+        *first = {state[0], state[1]};
+        staircase.erase(first + 1, above);
+      }
+      out.insert(out.end(), state, state + width);
+    }
+    stats.dominance_tests(states);
+    return;
+  }
+
+  std::vector<T> coords(states * 3);
+  for (size_t id = 0; id < states; ++id) {
+    const T *state = merged.data() + id * width;
+    for (size_t c = 0; c < 3; ++c) {
+      coords[id * 3 + c] = c < layout.m ? state[c] : -state[c];
+    }
+  }
+  std::vector<uint8_t> flagged(states, 0);
+  stats.dominance_tests(layered_detail::dominance_sweep<T>(coords, flagged).run());
+
+  std::vector<size_t> kept[2];
+  for (size_t s = 0, id = 0; s < merged.size(); s += width, ++id) {
+    const T *state = merged.data() + s;
+    bool dominated = flagged[id] && columns == 3;
+    if (flagged[id] && columns > 3) {
+      const auto &others = kept[!from_shifted[id]];
+      size_t tests = 0;
+      for (auto it = others.rbegin(); it != others.rend() && !dominated; ++it) {
+        ++tests;
+        dominated = layout.dominates(out.data() + *it, state);
+      }
+      stats.dominance_tests(tests);
+    }
+    if (!dominated) {
+      kept[from_shifted[id]].push_back(out.size());
+      out.insert(out.end(), state, state + width);
+    }
+  }
+}
+
+// Non-dominated objective vectors of a set of states, ignoring the weights.
+template <typename T>
+std::vector<std::vector<T>> front_of_states(const state_vector<T> &states, size_t m, size_t width) {
+  MOBKP_TRACE_SPAN("front", "dp");
+  std::vector<std::vector<T>> points;
+  points.reserve(states.size() / width);
+  for (size_t s = 0; s < states.size(); s += width) {
+    points.emplace_back(states.begin() + s, states.begin() + s + m);
+  }
+  // Lexicographically decreasing order puts dominating points first.
+  std::sort(points.begin(), points.end(), std::greater<>());
+  points.erase(std::unique(points.begin(), points.end()), points.end());
+
+  std::vector<std::vector<T>> front;
+  for (auto &p : points) {
+    bool dominated = false;
+    for (auto it = front.rbegin(); it != front.rend() && !dominated; ++it) {
+      dominated = std::equal(p.begin(), p.end(), it->begin(), [](T a, T b) { return a <= b; });
+    }
+    if (!dominated) {
+      front.push_back(std::move(p));
+    }
+  }
+  return front;
+}
+
+// Copies into `shifted` the states of `layer` that can take item i, with the
+// item added, in the same order.
+template <typename T, typename Problem, typename Stats>
+void shift_layer(const Problem &problem, size_t i, const std::vector<T> &capacity, const state_vector<T> &layer,
+                 state_vector<T> &shifted, Stats &stats) {
+  const size_t m = problem.num_objectives();
+  const size_t k = problem.num_constraints();
+  const auto layout = state_layout<T>{m, k};
+  const size_t width = layout.width();
+  const size_t states = layer.size() / width;
+  const T capacity_sum = std::accumulate(capacity.begin(), capacity.end(), T(0));
+
+  auto values = problem.item_values(i);
+  auto weights = problem.item_weights(i);
+  std::vector<T> item(width);
+  for (size_t j = 0; j < m; ++j) {
+    item[j] = values[j];
+  }
+  for (size_t j = 0; j < k; ++j) {
+    item[m + j] = weights[j];
+  }
+  const T item_sum = layout.weight_sum(item.data());
+  // Weight a state may carry in each constraint and still take the item, so
+  // the k checks are one branch-free comparison per constraint.
+  std::vector<T> residual(k);
+  for (size_t j = 0; j < k; ++j) {
+    residual[j] = capacity[j] - item[m + j];
+  }
+
+  shifted.clear();
+  for (size_t s = 0; s < layer.size(); s += width) {
+    const T *state = layer.data() + s;
+    if (layout.weight_sum(state) + item_sum > capacity_sum) {
+      // States are sorted by total weight, none further fits.
+      stats.capacity_rejections(states - s / width);
+      break;
+    }
+    bool feasible = true;
+    for (size_t j = 0; j < k; ++j) {
+      feasible &= state[m + j] <= residual[j];
+    }
+    if (!feasible) {
+      stats.capacity_rejection();
+      continue;
+    }
+    stats.candidate();
+    for (size_t j = 0; j < width; ++j) {
+      shifted.push_back(state[j] + item[j]);
+    }
+  }
+}
+
+// Merges the sorted `layer` and `shifted` into `merged`, keeping one of each
+// pair of equal states; `from_shifted[s]` tells the origin of state s.
+template <typename T>
+void merge_layers(const state_layout<T> &layout, const state_vector<T> &layer, const state_vector<T> &shifted,
+                  state_vector<T> &merged, std::vector<uint8_t> &from_shifted) {
+  const size_t width = layout.width();
+  merged.clear();
+  from_shifted.clear();
+  size_t a = 0, b = 0;
+  while (a < layer.size() || b < shifted.size()) {
+    if (b == shifted.size() || (a < layer.size() && layout.before(layer.data() + a, shifted.data() + b))) {
+      merged.insert(merged.end(), layer.data() + a, layer.data() + a + width);
+      from_shifted.push_back(0);
+      a += width;
+    } else if (a == layer.size() || layout.before(shifted.data() + b, layer.data() + a)) {
+      merged.insert(merged.end(), shifted.data() + b, shifted.data() + b + width);
+      from_shifted.push_back(1);
+      b += width;
+    } else {
+      // Equal states, keep one.
+      merged.insert(merged.end(), layer.data() + a, layer.data() + a + width);
+      from_shifted.push_back(0);
+      a += width;
+      b += width;
+    }
+  }
+}
+
+// Called with the number of items done and the layer after each item.
+template <typename T>
+using layer_observer = std::function<void(size_t, const state_vector<T> &)>;
+
+// Drops states of the layer after the given number of items, before it is observed.
+template <typename T>
+using layer_pruner = std::function<void(size_t, state_vector<T> &)>;
+
+// Layer to start from instead of the empty knapsack, after the first `item` items.
+template <typename T>
+struct dp_start {
+  size_t item = 0;
+  state_vector<T> layer;
+};
+
+// Optional hooks of the native DPs.
+template <typename T>
+struct dp_hooks {
+  dp_start<T> resume;
+  layer_pruner<T> prune;
+  layer_observer<T> observe;
+};
+
+// Extends `layer` with item i; `shifted`, `merged` and `from_shifted` are
+// scratch space reused between layers. Returns the number of states of the new layer.
+template <typename T, typename Problem, typename Stats>
+size_t extend_layer(const Problem &problem, size_t i, const std::vector<T> &capacity, state_vector<T> &layer,
+                    state_vector<T> &shifted, state_vector<T> &merged, std::vector<uint8_t> &from_shifted, Stats &stats,
+                    const layer_pruner<T> &prune = nullptr) {
+  MOBKP_TRACE_SPAN("layer", "dp");
+  const auto layout = state_layout<T>{problem.num_objectives(), problem.num_constraints()};
+  const size_t width = layout.width();
+
+  stats.begin_layer(i, layer.size() / width);
+  shift_layer(problem, i, capacity, layer, shifted, stats);
+  merge_layers(layout, layer, shifted, merged, from_shifted);
+  filter_merged(layout, merged, from_shifted, layer, stats);
+  if (prune) {
+    prune(i + 1, layer);
+  }
+  const size_t bytes = (layer.capacity() + shifted.capacity() + merged.capacity()) * sizeof(T) + from_shifted.capacity();
+  stats.end_layer(layer.size() / width, bytes);
+  return layer.size() / width;
+}
+
+template <typename T, typename Problem, typename Stats = no_stats>
+std::vector<std::vector<T>> layered_dp(const Problem &problem, double timeout, Stats &stats, dp_hooks<T> hooks = {}) {
+  const auto start = std::chrono::steady_clock::now();
+  const size_t n = problem.num_items();
+  const size_t m = problem.num_objectives();
+  const size_t k = problem.num_constraints();
+  const size_t width = m + k;
+
+  std::vector<T> capacity(k);
+  for (size_t j = 0; j < k; ++j) {
+    capacity[j] = problem.weight_capacity(j);
+  }
+
+  state_vector<T> layer = hooks.resume.layer.empty() ? state_vector<T>(width, 0) : std::move(hooks.resume.layer);
+  state_vector<T> shifted, merged;
+  std::vector<uint8_t> from_shifted;
+  for (size_t i = hooks.resume.item; i < n; ++i) {
+    if (std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count() > timeout) {
+      break;
+    }
+    extend_layer(problem, i, capacity, layer, shifted, merged, from_shifted, stats, hooks.prune);
+    if (hooks.observe) {
+      hooks.observe(i + 1, layer);
+    }
+  }
+  return front_of_states(layer, m, width);
+}
+
+#endif  // LAYERED_DP_HPP
@@ -0,0 +1,226 @@
+#ifndef MANY_DP_HPP
+#define MANY_DP_HPP
+
+#include <algorithm>
+#include <chrono>
+#include <cstdint>
+#include <numeric>
+#include <stdexcept>
+#include <thread>
+#include <vector>
+
+#include <layered_dp.hpp>
+#include <pages.hpp>
+#include <state.hpp>
+#include <stats.hpp>
+#include <trace.hpp>
+
+// Layered DP for many objectives (m = 5..8).
+//
+// With many objectives few states dominate one another, so the sweep of
+// filter_merged, which only sees three of the columns, flags most states and
+// their scans run through almost every kept state before giving up. Here
+// the merged layer is filtered as two batch queries instead: a state is
+// dominated only if a state of the other input dominates it (both inputs are
+// free of dominated states, so by transitivity the states of the other input
+// that are themselves removed need not be excluded). The queries are
+// independent and run in parallel.
+//
+// Each input is indexed by dimension: its states are ranked on every
+// objective and weight, the ranks cut into buckets, and for each bucket a
+// bitset holds the states ranked no worse. ANDing, over the dimensions, the
+// bitsets of the buckets a query falls in leaves a superset of its
+// dominators, restricted to the states that precede it in the merged order;
+// only those are tested exactly.
+
+template <typename T>
+class dominance_index {
+ public:
+  dominance_index(const state_layout<T> &layout, const state_vector<T> &merged, const std::vector<size_t> &members)
+      : layout(layout), merged(merged), members(members) {
+    const size_t n = members.size();
+    const size_t dims = layout.width();
+    words = (n + 63) / 64;
+    buckets = std::max<size_t>(1, std::min(max_buckets, n));
+    bucket_size = (n + buckets - 1) / std::max<size_t>(1, buckets);
+    keys.resize(dims);
+    bits.resize(dims);
+    std::vector<size_t> order(n);
+    for (size_t j = 0; j < dims; ++j) {
+      // Better first: decreasing values, increasing weights.
+      const bool value = j < layout.m;
+      std::iota(order.begin(), order.end(), 0);
+      std::sort(order.begin(), order.end(), [&](size_t a, size_t b) {
+        return value ? coordinate(a, j) > coordinate(b, j) : coordinate(a, j) < coordinate(b, j);
+      });
+      keys[j].resize(n);
+      bits[j].assign(buckets * words, 0);
+      for (size_t r = 0; r < n; ++r) {
+        keys[j][r] = coordinate(order[r], j);
+        const size_t b = r / bucket_size;
+        bits[j][b * words + order[r] / 64] |= uint64_t(1) << (order[r] % 64);
+      }
+      for (size_t b = 1; b < buckets; ++b) {
+        for (size_t w = 0; w < words; ++w) {
+          bits[j][b * words + w] |= bits[j][(b - 1) * words + w];
+        }
+      }
+    }
+  }
+
+  // Whether one of the first `limit` members dominates `state`; `tests`
+  // counts the exact dominance tests.
+  bool dominated(const T *state, size_t limit, size_t &tests) const {
+    if (limit == 0) {
+      return false;
+    }
+    const size_t dims = layout.width();
+    const uint64_t *masks[max_dims];
+    for (size_t j = 0; j < dims; ++j) {
+      const auto &key = keys[j];
+      const T c = state[j];
+      const size_t count = j < layout.m
+                               ? std::partition_point(key.begin(), key.end(), [c](T v) { return v >= c; }) - key.begin()
+                               : std::partition_point(key.begin(), key.end(), [c](T v) { return v <= c; }) - key.begin();
+      if (count == 0) {
+        return false;  // no member is as good on this dimension
+      }
+      masks[j] = bits[j].data() + (count - 1) / bucket_size * words;
+    }
+    // Latest members first, as the nearest states in the order dominate most often.
+    for (size_t w = (limit + 63) / 64; w-- > 0;) {
+      uint64_t candidates = w + 1 == (limit + 63) / 64 && limit % 64 != 0 ? (uint64_t(1) << (limit % 64)) - 1 : ~uint64_t(0);
+      for (size_t j = 0; j < dims && candidates != 0; ++j) {
+        candidates &= masks[j][w];
+      }
+      while (candidates != 0) {
+        const size_t bit = 63 - __builtin_clzll(candidates);
+        candidates &= ~(uint64_t(1) << bit);
+        ++tests;
+        if (layout.dominates(merged.data() + members[w * 64 + bit], state)) {
+          return true;
+        }
+      }
+    }
+    return false;
+  }
+
+  size_t bytes() const {
+    size_t total = members.capacity() * sizeof(size_t);
+    for (size_t j = 0; j < keys.size(); ++j) {
+      total += keys[j].capacity() * sizeof(T) + bits[j].capacity() * sizeof(uint64_t);
+    }
+    return total;
+  }
+
+  static constexpr size_t max_dims = 64;
+
+ private:
+  static constexpr size_t max_buckets = 32;
+
+  const state_layout<T> &layout;
+  const state_vector<T> &merged;
+  const std::vector<size_t> &members;  // offsets of the indexed states in `merged`, in order
+  size_t words = 0;
+  size_t buckets = 0;
+  size_t bucket_size = 1;
+  std::vector<std::vector<T>> keys;         // per dimension, the coordinates from best to worst
+  std::vector<std::vector<uint64_t>> bits;  // per dimension and bucket, the members ranked in it or better
+
+  T coordinate(size_t member, size_t j) const { return merged[members[member] + j]; }
+};
+
+// Removes the dominated states of `merged` into `out`, see above.
+template <typename T, typename Stats>
+size_t filter_merged_many(const state_layout<T> &layout, const state_vector<T> &merged,
+                          const std::vector<uint8_t> &from_shifted, state_vector<T> &out, size_t threads, Stats &stats) {
+  MOBKP_TRACE_SPAN("filter", "dp");
+  const size_t width = layout.width();
+  const size_t states = merged.size() / width;
+  std::vector<size_t> members[2];
+  std::vector<size_t> preceding(states);  // members of the other input before each state
+  for (size_t id = 0; id < states; ++id) {
+    preceding[id] = members[!from_shifted[id]].size();
+    members[from_shifted[id]].push_back(id * width);
+  }
+  const dominance_index<T> index[2] = {dominance_index<T>(layout, merged, members[0]),
+                                       dominance_index<T>(layout, merged, members[1])};
+
+  std::vector<uint8_t> dominated(states, 0);
+  std::vector<size_t> tests(threads, 0);
+  auto filter_range = [&](size_t t, size_t first, size_t last) {
+    for (size_t id = first; id < last; ++id) {
+      dominated[id] = index[!from_shifted[id]].dominated(merged.data() + id * width, preceding[id], tests[t]);
+    }
+  };
+  // Small layers are not worth the threads.
+  const size_t workers = std::min(threads, std::max<size_t>(1, states / 4096));
+  if (workers <= 1) {
+    filter_range(0, 0, states);
+  } else {
+    std::vector<std::thread> pool;
+    for (size_t t = 0; t < workers; ++t) {
+      pool.emplace_back(filter_range, t, states * t / workers, states * (t + 1) / workers);
+    }
+    for (auto &worker : pool) {
+      worker.join();
+    }
+  }
+  for (auto count : tests) {
+    stats.dominance_tests(count);
+  }
+
+  out.clear();
+  for (size_t id = 0; id < states; ++id) {
+    if (!dominated[id]) {
+      out.insert(out.end(), merged.data() + id * width, merged.data() + (id + 1) * width);
+    }
+  }
+  return index[0].bytes() + index[1].bytes() + preceding.capacity() * sizeof(size_t) + dominated.capacity();
+}
+
+template <typename T, typename Problem, typename Stats = no_stats>
+std::vector<std::vector<T>> many_dp(const Problem &problem, double timeout, size_t threads, Stats &stats,
+                                    dp_hooks<T> hooks = {}) {
+  const auto start = std::chrono::steady_clock::now();
+  const size_t n = problem.num_items();
+  const size_t m = problem.num_objectives();
+  const size_t k = problem.num_constraints();
+  const auto layout = state_layout<T>{m, k};
+  const size_t width = layout.width();
+  if (width > dominance_index<T>::max_dims) {
+    throw std::invalid_argument("The many-objective DP supports up to 64 objectives and constraints.");
+  }
+  threads = std::max<size_t>(1, threads);
+
+  std::vector<T> capacity(k);
+  for (size_t j = 0; j < k; ++j) {
+    capacity[j] = problem.weight_capacity(j);
+  }
+
+  state_vector<T> layer = hooks.resume.layer.empty() ? state_vector<T>(width, 0) : std::move(hooks.resume.layer);
+  state_vector<T> shifted, merged;
+  std::vector<uint8_t> from_shifted;
+  for (size_t i = hooks.resume.item; i < n; ++i) {
+    if (std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count() > timeout) {
+      break;
+    }
+    MOBKP_TRACE_SPAN("layer", "dp");
+    stats.begin_layer(i, layer.size() / width);
+    shift_layer(problem, i, capacity, layer, shifted, stats);
+    merge_layers(layout, layer, shifted, merged, from_shifted);
+    const size_t index_bytes = filter_merged_many(layout, merged, from_shifted, layer, threads, stats);
+    if (hooks.prune) {
+      hooks.prune(i + 1, layer);
+    }
+    const size_t bytes =
+        (layer.capacity() + shifted.capacity() + merged.capacity()) * sizeof(T) + from_shifted.capacity() + index_bytes;
+    stats.end_layer(layer.size() / width, bytes);
+    if (hooks.observe) {
+      hooks.observe(i + 1, layer);
+    }
+  }
+  return front_of_states(layer, m, width);
+}
+
+#endif  // MANY_DP_HPP
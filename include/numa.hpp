@@ -0,0 +1,97 @@
+#ifndef NUMA_HPP
+#define NUMA_HPP
+
+#include <pthread.h>
+#include <sched.h>
+#include <sys/syscall.h>
+#include <unistd.h>
+
+#include <algorithm>
+#include <cctype>
+#include <filesystem>
+#include <fstream>
+#include <sstream>
+#include <string>
+#include <thread>
+#include <vector>
+
+// NUMA placement of the worker threads, read from /sys without libnuma.
+//
+// A bound thread runs only on the CPUs of one node and prefers the memory of
+// that node, so the DP states a job allocates (first touched by the thread
+// that solves it) stay local to the socket that works on them.
+
+struct numa_node {
+  int id = 0;
+  std::vector<int> cpus;
+};
+
+// Parses a kernel cpu list such as "0-3,8-11".
+std::vector<int> parse_cpu_list(const std::string &list) {
+  std::vector<int> cpus;
+  std::stringstream ss(list);
+  std::string range;
+  while (std::getline(ss, range, ',')) {
+    if (range.empty() || range == "\n") {
+      continue;
+    }
+    const auto dash = range.find('-');
+    const int first = std::stoi(range.substr(0, dash));
+    const int last = dash == std::string::npos ? first : std::stoi(range.substr(dash + 1));
+    for (int cpu = first; cpu <= last; ++cpu) {
+      cpus.push_back(cpu);
+    }
+  }
+  return cpus;
+}
+
+// Nodes with CPUs, or a single node with every CPU when the topology is unknown.
+std::vector<numa_node> numa_nodes() {
+  std::vector<numa_node> nodes;
+  const std::filesystem::path root = "/sys/devices/system/node";
+  std::error_code ec;
+  for (auto const &entry : std::filesystem::directory_iterator(root, ec)) {
+    const auto name = entry.path().filename().string();
+    if (name.rfind("node", 0) != 0 || name.size() == 4 || !std::isdigit(static_cast<unsigned char>(name[4]))) {
+      continue;
+    }
+    auto in = std::ifstream(entry.path() / "cpulist");
+    std::string list;
+    std::getline(in, list);
+    auto node = numa_node{std::stoi(name.substr(4)), parse_cpu_list(list)};
+    if (!node.cpus.empty()) {
+      nodes.push_back(std::move(node));
+    }
+  }
+  std::sort(nodes.begin(), nodes.end(), [](auto const &a, auto const &b) { return a.id < b.id; });
+  if (nodes.empty()) {
+    auto node = numa_node{};
+    for (int cpu = 0; cpu < static_cast<int>(std::max(1u, std::thread::hardware_concurrency())); ++cpu) {
+      node.cpus.push_back(cpu);
+    }
+    nodes.push_back(std::move(node));
+  }
+  return nodes;
+}
+
+// Pins the calling thread to the CPUs of `node` and makes it allocate from the
+// node's memory first, falling back to other nodes when it is full. Returns
+// false when either step was refused.
+bool bind_thread_to_node(const numa_node &node) {
+  cpu_set_t set;
+  CPU_ZERO(&set);
+  for (int cpu : node.cpus) {
+    CPU_SET(cpu, &set);
+  }
+  bool bound = ::pthread_setaffinity_np(::pthread_self(), sizeof(set), &set) == 0;
+#ifdef SYS_set_mempolicy
+  constexpr int mpol_preferred = 1;  // MPOL_PREFERRED of <linux/mempolicy.h>
+  constexpr size_t mask_bits = 8 * sizeof(unsigned long);
+  std::vector<unsigned long> mask(node.id / mask_bits + 1, 0);
+  mask[node.id / mask_bits] |= 1ul << (node.id % mask_bits);
+  bound &= ::syscall(SYS_set_mempolicy, mpol_preferred, mask.data(), mask.size() * mask_bits + 1) == 0;
+#endif
+  return bound;
+}
+
+#endif  // NUMA_HPP
@@ -0,0 +1,233 @@
+#ifndef PAGES_HPP
+#define PAGES_HPP
+
+#include <linux/perf_event.h>
+#include <sys/mman.h>
+#include <sys/resource.h>
+#include <sys/syscall.h>
+#include <unistd.h>
+
+#include <atomic>
+#include <chrono>
+#include <cstdint>
+#include <fstream>
+#include <new>
+#include <stdexcept>
+#include <string>
+#include <vector>
+
+// Page backing of the DP state arrays.
+//
+// Arrays of at least `arena_threshold` bytes are mapped directly, aligned to
+// and rounded up to 2 MiB, and backed according to the page policy of the
+// solving thread:
+//
+//   off      default pages of the system
+//   thp      transparent huge pages, madvise(MADV_HUGEPAGE)
+//   hugetlb  pages of the hugetlbfs pool (MAP_HUGETLB), thp when the pool is empty
+//
+// With `prefault` every page is touched when the array is mapped, so the page
+// faults are paid up front rather than during the dominance scans. Smaller
+// arrays use operator new.
+
+enum class page_mode { off, thp, hugetlb };
+
+page_mode parse_page_mode(const std::string &name) {
+  if (name == "off" || name.empty()) {
+    return page_mode::off;
+  }
+  if (name == "thp") {
+    return page_mode::thp;
+  }
+  if (name == "hugetlb") {
+    return page_mode::hugetlb;
+  }
+  throw std::invalid_argument("Invalid huge pages mode. Must be off, thp or hugetlb.");
+}
+
+struct page_policy {
+  page_mode mode = page_mode::off;
+  bool prefault = false;
+};
+
+inline page_policy &current_page_policy() {
+  thread_local page_policy policy;
+  return policy;
+}
+
+// Sets the page policy of the calling thread for the lifetime of the object.
+class scoped_page_policy {
+ public:
+  explicit scoped_page_policy(page_policy policy) : previous(current_page_policy()) { current_page_policy() = policy; }
+  ~scoped_page_policy() { current_page_policy() = previous; }
+  scoped_page_policy(const scoped_page_policy &) = delete;
+  scoped_page_policy &operator=(const scoped_page_policy &) = delete;
+
+ private:
+  page_policy previous;
+};
+
+// Process-wide totals of the mapped arenas.
+struct page_counters {
+  std::atomic<size_t> mapped_bytes{0};    // bytes mapped so far
+  std::atomic<size_t> hugetlb_bytes{0};   // of which from the hugetlbfs pool
+  std::atomic<int64_t> map_ns{0};         // time spent mapping, including the prefault
+  std::atomic<int64_t> prefault_ns{0};    // time spent touching the pages
+};
+
+inline page_counters &global_page_counters() {
+  static page_counters counters;
+  return counters;
+}
+
+// Time the calling thread spent mapping arenas, including the prefault.
+inline int64_t &thread_map_ns() {
+  thread_local int64_t ns = 0;
+  return ns;
+}
+
+constexpr size_t huge_page_bytes = size_t(2) << 20;
+constexpr size_t arena_threshold = huge_page_bytes;
+
+inline size_t arena_length(size_t bytes) { return (bytes + huge_page_bytes - 1) / huge_page_bytes * huge_page_bytes; }
+
+void *map_arena(size_t bytes) {
+  const auto start = std::chrono::steady_clock::now();
+  const auto policy = current_page_policy();
+  auto &counters = global_page_counters();
+  const size_t length = arena_length(bytes);
+
+  void *data = MAP_FAILED;
+  if (policy.mode == page_mode::hugetlb) {
+    data = ::mmap(nullptr, length, PROT_READ | PROT_WRITE, MAP_PRIVATE | MAP_ANONYMOUS | MAP_HUGETLB, -1, 0);
+    if (data != MAP_FAILED) {
+      counters.hugetlb_bytes += length;
+    }
+  }
+  if (data == MAP_FAILED) {
+    // Over-map by a huge page and trim, so the arena starts on a 2 MiB boundary.
+    void *raw = ::mmap(nullptr, length + huge_page_bytes, PROT_READ | PROT_WRITE, MAP_PRIVATE | MAP_ANONYMOUS, -1, 0);
+    if (raw == MAP_FAILED) {
+      throw std::bad_alloc();
+    }
+    const auto address = reinterpret_cast<uintptr_t>(raw);
+    const auto aligned = (address + huge_page_bytes - 1) / huge_page_bytes * huge_page_bytes;
+    if (aligned > address) {
+      ::munmap(raw, aligned - address);
+    }
+    if (address + huge_page_bytes > aligned) {
+      ::munmap(reinterpret_cast<void *>(aligned + length), address + huge_page_bytes - aligned);
+    }
+    data = reinterpret_cast<void *>(aligned);
+    if (policy.mode != page_mode::off) {
+      ::madvise(data, length, MADV_HUGEPAGE);
+    }
+  }
+  counters.mapped_bytes += length;
+
+  if (policy.prefault) {
+    const auto prefault_start = std::chrono::steady_clock::now();
+    volatile char *pages = static_cast<char *>(data);
+    for (size_t offset = 0; offset < length; offset += 4096) {
+      pages[offset] = 0;
+    }
+    counters.prefault_ns +=
+        std::chrono::duration_cast<std::chrono::nanoseconds>(std::chrono::steady_clock::now() - prefault_start).count();
+  }
+  const int64_t ns = std::chrono::duration_cast<std::chrono::nanoseconds>(std::chrono::steady_clock::now() - start).count();
+  counters.map_ns += ns;
+  thread_map_ns() += ns;
+  return data;
+}
+
+void unmap_arena(void *data, size_t bytes) { ::munmap(data, arena_length(bytes)); }
+
+// Allocator of the DP state arrays, see above.
+template <typename T>
+struct state_allocator {
+  using value_type = T;
+
+  state_allocator() = default;
+  template <typename U>
+  state_allocator(const state_allocator<U> &) {}
+
+  T *allocate(size_t n) {
+    const size_t bytes = n * sizeof(T);
+    if (bytes >= arena_threshold) {
+      return static_cast<T *>(map_arena(bytes));
+    }
+    return static_cast<T *>(::operator new(bytes));
+  }
+  void deallocate(T *data, size_t n) {
+    const size_t bytes = n * sizeof(T);
+    if (bytes >= arena_threshold) {
+      unmap_arena(data, bytes);
+    } else {
+      ::operator delete(data);
+    }
+  }
+
+  friend bool operator==(const state_allocator &, const state_allocator &) { return true; }
+  friend bool operator!=(const state_allocator &, const state_allocator &) { return false; }
+};
+
+template <typename T>
+using state_vector = std::vector<T, state_allocator<T>>;
+
+// Page faults (minor and major) of the calling thread.
+int64_t thread_page_faults() {
+  struct rusage usage;
+  if (::getrusage(RUSAGE_THREAD, &usage) != 0) {
+    return 0;
+  }
+  return usage.ru_minflt + usage.ru_majflt;
+}
+
+// Data TLB load misses of the calling thread, from a perf event. Reads -1 when
+// perf events are not available (e.g. perf_event_paranoid or a container).
+class tlb_counter {
+ public:
+  tlb_counter() {
+    perf_event_attr attr = {};
+    attr.type = PERF_TYPE_HW_CACHE;
+    attr.size = sizeof(attr);
+    attr.config = PERF_COUNT_HW_CACHE_DTLB | (PERF_COUNT_HW_CACHE_OP_READ << 8) | (PERF_COUNT_HW_CACHE_RESULT_MISS << 16);
+    attr.exclude_kernel = 1;
+    attr.exclude_hv = 1;
+    fd = static_cast<int>(::syscall(SYS_perf_event_open, &attr, 0, -1, -1, 0));
+  }
+  ~tlb_counter() {
+    if (fd >= 0) {
+      ::close(fd);
+    }
+  }
+  tlb_counter(const tlb_counter &) = delete;
+  tlb_counter &operator=(const tlb_counter &) = delete;
+
+  int64_t read() const {
+    uint64_t value = 0;
+    if (fd < 0 || ::read(fd, &value, sizeof(value)) != sizeof(value)) {
+      return -1;
+    }
+    return static_cast<int64_t>(value);
+  }
+
+ private:
+  int fd = -1;
+};
+
+// AnonHugePages of the process in bytes, the memory actually backed by
+// transparent huge pages.
+int64_t anon_huge_bytes() {
+  auto smaps = std::ifstream("/proc/self/smaps_rollup");
+  const std::string key = "AnonHugePages:";
+  std::string line;
+  while (std::getline(smaps, line)) {
+    if (line.rfind(key, 0) == 0) {
+      return std::stoll(line.substr(key.size())) * 1024;
+    }
+  }
+  return 0;
+}
+
+#endif  // PAGES_HPP
@@ -1,36 +1,98 @@
 #ifndef PARSER_HPP
 #define PARSER_HPP
 
+#include <algorithm>
 #include <cassert>
 #include <iostream>
+#include <memory>
+#include <thread>
+#include <sstream>
 #include <stdexcept>
 #include <string>
+#include <utility>
+#include <vector>
 
 class Arguments {
  public:
-  Arguments(int argc, char **argv) : argc(argc), argv(argv) {
+  Arguments(int argc, char **argv) : argc(argc), argv(argv), options(argv + 1, argv + argc) {
     type = 0;
     seed = time(0);
     correlation = 0.0;
     n = 0;
     m = 0;
+    k = 1;
+    multiplicity = 10;
+    correlation_class = "uncorrelated";
+    class_noise = -1.0;
+    sampler = "r";
     weight_factor = 0.5;
     timeout = 604800.0;
+    external_memory = 1024;
+    external_items = 1;
+    algorithm = "mobkp";
+    progress = 0.0;
+    estimate = 0.0;
+    lease_expiry = 60.0;
+    heartbeat = 10.0;
+    workers = std::max(1u, std::thread::hardware_concurrency());
+    threads = std::max(1u, std::thread::hardware_concurrency());
+    numa = "on";
+    huge_pages = "off";
+    prefault = false;
+    target_front = 0;
+    search = "n";
+    presolve = 0.0;
     parse_arguments(argv);
     validate_arguments();
   }
 
   static void print_usage() {
     std::cout << "Usage: [options]\n"
-              << "--type=<0|1|2>          Type of instance (0: random, 1: negative correlation, 2: positive correlation)\n"
+              << "--type=<0|1|2|3>        Type of instance (0: random, 1: negative correlation, 2: positive correlation, 3: bounded)\n"
               << "--outfile=<filename>    Output file name\n"
               << "--seed=<number>         Seed value\n"
               << "--correlation=<number>  Correlation value between objectives: -1.0 <= correlation < 0.0 (negative), 0.0 < correlation <= 1.0 (positive)\n"
               << "--n=<number>            Value of n (number of variables)\n"
               << "--m=<number>            Value of m (number of objectives)\n"
+              << "--k=<number>            Number of knapsack constraints (weight dimensions)\n"
+              << "--multiplicity=<number> Maximum number of copies of an item of a bounded instance\n"
+              << "--class=<name>          Weight-profit correlation of random and bounded instances (uncorrelated, weak, strong,\n"
+              << "                        inverse, almost or subset-sum)\n"
+              << "--class-noise=<number>  Width of the profit noise of the class, as a fraction of the coefficient range\n"
+              << "--sampler=<r|native>    Sampler of correlated instances (r: scripts/generator.R, native: built-in)\n"
               << "--weight-factor=<number> Weight factor\n"
               << "--timeout=<number>      Timeout value in seconds\n"
-              << "Default values: type=0, outfile=n_seed.in, seed=time(0), correlation=0.0, weight-factor=0.5, timeout=7 days\n";
+              << "--external-dir=<path>   Spill the DP layers of m>=3 solves to this directory (external-memory DP)\n"
+              << "--external-memory=<MiB> Memory budget of the external-memory DP\n"
+              << "--external-items=<number> Items merged per pass over a spilled layer\n"
+              << "--algorithm=<name>      Solver engine (mobkp: mobkp library DPs, layered: native in-memory DP,\n"
+              << "                        many: native DP for many objectives, bnb: parallel branch and bound,\n"
+              << "                        core: core-problem DP for large bi-objective instances)\n"
+              << "--threads=<number>      Threads of the many-objective DP, the branch and bound and the presolve\n"
+              << "--stats=<json|csv>      Write a per-layer report of the native engines next to the instance\n"
+              << "--trace=<filename>      Write a Chrome trace of the run (needs a build with MOBKP_TRACE=ON)\n"
+              << "--progress=<number>     Report the progress of the solve every given seconds\n"
+              << "--status-file=<filename> Write the progress to this file instead of stderr\n"
+              << "--estimate[=<seconds>]  Predict the front size, memory and runtime from sub-instances instead of solving\n"
+              << "--shard-dir=<path>      Claim and run the jobs of <path>/jobs.txt with other workers sharing the directory\n"
+              << "--lease-expiry=<number> Seconds without heartbeat after which a claimed job is claimed again\n"
+              << "--heartbeat=<number>    Seconds between the heartbeats of a claimed job\n"
+              << "--huge-pages=<off|thp|hugetlb> Page backing of the large state arrays of the native engines\n"
+              << "--prefault              Touch the pages of the large state arrays when they are allocated\n"
+              << "--daemon=<socket>       Serve generate/solve/verify jobs on this Unix domain socket\n"
+              << "--workers=<number>      Worker threads of the daemon\n"
+              << "--numa=<on|off>         Spread the daemon workers over the NUMA nodes, bound to node-local memory\n"
+              << "--target-front=<number> Search for an instance with a front of about this size, then solve only that one\n"
+              << "--search=<n|weight-factor|correlation> Parameter bisected by the target front search\n"
+              << "--n-sweep=<n1,n2,...>   Write the instances of these n, prefixes of one item list, from a single DP pass\n"
+              << "--save-snapshot=<filename> Save the final DP states of the solve, to extend the instance later\n"
+              << "--extend-from=<filename> Solve from a saved snapshot of the first items, at its capacity\n"
+              << "--presolve[=<seconds>] Prune the DP states with a heuristic front found within this time\n"
+              << "--stream=<filename>     Write the points of the front to this file (or FIFO) as soon as they are final\n"
+              << "Default values: type=0, outfile=n_seed.in, seed=time(0), correlation=0.0, k=1, multiplicity=10, class=uncorrelated, sampler=r, weight-factor=0.5, timeout=7 days,\n"
+              << "                external-memory=1024, external-items=1, algorithm=mobkp, estimate=0.5 and presolve=0.2 when given without a value,\n"
+              << "                lease-expiry=60, heartbeat=10, workers=hardware threads, threads=hardware threads, numa=on,\n"
+              << "                huge-pages=off, search=n\n";
   }
 
   int32_t get_type() const { return type; }
@@ -39,9 +101,43 @@ class Arguments {
   double get_correlation() const { return correlation; }
   int32_t get_n() const { return n; }
   int32_t get_m() const { return m; }
+  int32_t get_k() const { return k; }
+  int32_t get_multiplicity() const { return multiplicity; }
+  std::string get_class() const { return correlation_class; }
+  double get_class_noise() const { return class_noise; }
+  std::string get_sampler() const { return sampler; }
   double get_timeout() const { return timeout; }
   double get_weight_factor() const { return weight_factor; }
   std::string get_folder_path() const { return folder_path; }
+  std::string get_external_dir() const { return external_dir; }
+  int64_t get_external_memory() const { return external_memory; }
+  int32_t get_external_items() const { return external_items; }
+  std::string get_algorithm() const { return algorithm; }
+  std::string get_stats() const { return stats; }
+  std::string get_trace() const { return trace; }
+  double get_progress() const { return progress; }
+  std::string get_status_file() const { return status_file; }
+  double get_estimate() const { return estimate; }
+  std::string get_shard_dir() const { return shard_dir; }
+  double get_lease_expiry() const { return lease_expiry; }
+  double get_heartbeat() const { return heartbeat; }
+  std::string get_daemon() const { return daemon; }
+  int32_t get_workers() const { return workers; }
+  int32_t get_threads() const { return threads; }
+  bool get_numa() const { return numa == "on"; }
+  std::string get_huge_pages() const { return huge_pages; }
+  bool get_prefault() const { return prefault; }
+  int64_t get_target_front() const { return target_front; }
+  std::string get_search() const { return search; }
+  std::string get_stream() const { return stream; }
+  std::string get_save_snapshot() const { return save_snapshot; }
+  std::string get_extend_from() const { return extend_from; }
+  double get_presolve() const { return presolve; }
+  const std::vector<int32_t> &get_n_sweep() const { return n_sweep; }
+
+  // The same options with `key` (e.g. "--n") set to `value` instead.
+  std::unique_ptr<Arguments> with_option(const std::string &key, const std::string &value) const;
+  std::unique_ptr<Arguments> with_options(const std::vector<std::pair<std::string, std::string>> &changes) const;
 
   void print_arguments() {
     std::cout << "type: " << type << std::endl;
@@ -49,24 +145,85 @@ class Arguments {
     std::cout << "correlation: " << correlation << std::endl;
     std::cout << "n: " << n << std::endl;
     std::cout << "m: " << m << std::endl;
+    std::cout << "k: " << k << std::endl;
+    std::cout << "multiplicity: " << multiplicity << std::endl;
+    std::cout << "class: " << correlation_class << std::endl;
+    std::cout << "class_noise: " << class_noise << std::endl;
+    std::cout << "sampler: " << sampler << std::endl;
     std::cout << "timeout: " << timeout << std::endl;
     std::cout << "weight_factor: " << weight_factor << std::endl;
     std::cout << "folder_path: " << folder_path << std::endl;
     std::cout << "outfile: " << outfile << std::endl;
+    std::cout << "external_dir: " << external_dir << std::endl;
+    std::cout << "external_memory: " << external_memory << std::endl;
+    std::cout << "external_items: " << external_items << std::endl;
+    std::cout << "algorithm: " << algorithm << std::endl;
+    std::cout << "stats: " << stats << std::endl;
+    std::cout << "trace: " << trace << std::endl;
+    std::cout << "progress: " << progress << std::endl;
+    std::cout << "status_file: " << status_file << std::endl;
+    std::cout << "estimate: " << estimate << std::endl;
+    std::cout << "shard_dir: " << shard_dir << std::endl;
+    std::cout << "lease_expiry: " << lease_expiry << std::endl;
+    std::cout << "heartbeat: " << heartbeat << std::endl;
+    std::cout << "daemon: " << daemon << std::endl;
+    std::cout << "workers: " << workers << std::endl;
+    std::cout << "threads: " << threads << std::endl;
+    std::cout << "numa: " << numa << std::endl;
+    std::cout << "huge_pages: " << huge_pages << std::endl;
+    std::cout << "prefault: " << prefault << std::endl;
+    std::cout << "target_front: " << target_front << std::endl;
+    std::cout << "search: " << search << std::endl;
+    std::cout << "stream: " << stream << std::endl;
+    std::cout << "save_snapshot: " << save_snapshot << std::endl;
+    std::cout << "extend_from: " << extend_from << std::endl;
+    std::cout << "presolve: " << presolve << std::endl;
+    std::cout << "n_sweep: " << n_sweep.size() << " sizes" << std::endl;
   }
 
  private:
   int argc;
   char **argv;
+  std::vector<std::string> options;
   int32_t type;
   std::string outfile;
   int64_t seed;
   double correlation;
   int32_t n;
   int32_t m;
+  int32_t k;
+  int32_t multiplicity;
+  std::string correlation_class;
+  double class_noise;  // negative for the default of the class
+  std::string sampler;
   double timeout;
   double weight_factor;
   std::string folder_path;
+  std::string external_dir;
+  int64_t external_memory;
+  int32_t external_items;
+  std::string algorithm;
+  std::string stats;
+  std::string trace;
+  double progress;
+  std::string status_file;
+  double estimate;
+  std::string shard_dir;
+  double lease_expiry;
+  double heartbeat;
+  std::string daemon;
+  int32_t workers;
+  int32_t threads;
+  std::string numa;
+  std::string huge_pages;
+  bool prefault;
+  int64_t target_front;
+  std::string search;
+  std::string stream;
+  std::string save_snapshot;
+  std::string extend_from;
+  double presolve;
+  std::vector<int32_t> n_sweep;  // ascending
 
   void parse_arguments(char **argv) {
     for (int i = 1; i < argc; ++i) {
@@ -87,10 +244,75 @@ class Arguments {
         n = std::stoi(value);
       } else if (key == "--m") {
         m = std::stoi(value);
+      } else if (key == "--k") {
+        k = std::stoi(value);
+      } else if (key == "--multiplicity") {
+        multiplicity = std::stoi(value);
+      } else if (key == "--class") {
+        correlation_class = value;
+      } else if (key == "--class-noise") {
+        class_noise = std::stod(value);
+      } else if (key == "--sampler") {
+        sampler = value;
       } else if (key == "--weight-factor") {
         weight_factor = std::stod(value);
       } else if (key == "--timeout") {
         timeout = std::stod(value);
+      } else if (key == "--external-dir") {
+        external_dir = value;
+      } else if (key == "--external-memory") {
+        external_memory = std::stoll(value);
+      } else if (key == "--external-items") {
+        external_items = std::stoi(value);
+      } else if (key == "--algorithm") {
+        algorithm = value;
+      } else if (key == "--stats") {
+        stats = value;
+      } else if (key == "--trace") {
+        trace = value;
+      } else if (key == "--progress") {
+        progress = std::stod(value);
+      } else if (key == "--status-file") {
+        status_file = value;
+      } else if (key == "--estimate") {
+        estimate = value.empty() ? 0.5 : std::stod(value);
+      } else if (key == "--shard-dir") {
+        shard_dir = value;
+      } else if (key == "--lease-expiry") {
+        lease_expiry = std::stod(value);
+      } else if (key == "--heartbeat") {
+        heartbeat = std::stod(value);
+      } else if (key == "--daemon") {
+        daemon = value;
+      } else if (key == "--workers") {
+        workers = std::stoi(value);
+      } else if (key == "--threads") {
+        threads = std::stoi(value);
+      } else if (key == "--numa") {
+        numa = value;
+      } else if (key == "--huge-pages") {
+        huge_pages = value;
+      } else if (key == "--prefault") {
+        prefault = true;
+      } else if (key == "--target-front") {
+        target_front = std::stoll(value);
+      } else if (key == "--search") {
+        search = value;
+      } else if (key == "--stream") {
+        stream = value;
+      } else if (key == "--save-snapshot") {
+        save_snapshot = value;
+      } else if (key == "--extend-from") {
+        extend_from = value;
+      } else if (key == "--presolve") {
+        presolve = value.empty() ? 0.2 : std::stod(value);
+      } else if (key == "--n-sweep") {
+        n_sweep.clear();
+        std::istringstream ss(value);
+        std::string size;
+        while (std::getline(ss, size, ',')) {
+          n_sweep.push_back(std::stoi(size));
+        }
       } else {
         print_usage();
         throw std::invalid_argument("Unknown argument: " + key);
@@ -99,13 +321,30 @@ class Arguments {
   }
 
   void validate_arguments() {
-    if (type < 0 || type > 2) {
-      throw std::invalid_argument("Invalid type value. Must be between 0 and 2.");
+    if (!shard_dir.empty()) {
+      // A shard worker takes the instance options from the jobs it claims.
+      if (heartbeat <= 0.0 || lease_expiry <= heartbeat) {
+        throw std::invalid_argument("Heartbeat must be greater than 0.0 and lower than the lease expiry.");
+      }
+      return;
+    }
+    if (!daemon.empty()) {
+      // The daemon takes the instance options from the jobs it receives.
+      if (workers <= 0) {
+        throw std::invalid_argument("Workers must be greater than 0.");
+      }
+      if (numa != "on" && numa != "off") {
+        throw std::invalid_argument("Invalid numa value. Must be on or off.");
+      }
+      return;
+    }
+    if (type < 0 || type > 3) {
+      throw std::invalid_argument("Invalid type value. Must be between 0 and 3.");
     }
     if (seed < 0) {
       throw std::invalid_argument("Seed must be non-negative.");
     }
-    if (type != 0) {
+    if (type == 1 || type == 2) {
       if (type == 1) {
         if (correlation >= 0.0 || correlation <= -1.0 / (m - 1)) {
           throw std::invalid_argument("Correlation must be between -1/(m-1) and 0.0.");
@@ -116,18 +355,136 @@ class Arguments {
         }
       }
     }
+    if (!n_sweep.empty()) {
+      std::sort(n_sweep.begin(), n_sweep.end());
+      n_sweep.erase(std::unique(n_sweep.begin(), n_sweep.end()), n_sweep.end());
+      if (n_sweep.front() <= 0) {
+        throw std::invalid_argument("The sizes of the sweep must be greater than 0.");
+      }
+      if (type != 0 && type != 3) {
+        throw std::invalid_argument("A size sweep needs prefix-consistent items, random or bounded instances (type 0 or 3).");
+      }
+      if (!outfile.empty() || estimate > 0.0 || target_front > 0 || !stream.empty()) {
+        throw std::invalid_argument("A size sweep names its instances and cannot be combined with --outfile, --estimate, "
+                                    "--target-front or --stream.");
+      }
+      n = n_sweep.back();
+    }
     if (n <= 0) {
       throw std::invalid_argument("n must be greater than 0.");
     }
     if (m <= 1) {
       throw std::invalid_argument("m must be greater than 1.");
     }
+    if (k < 1) {
+      throw std::invalid_argument("k must be greater than 0.");
+    }
+    if (k > 1 && (type == 1 || type == 2)) {
+      throw std::invalid_argument("The correlated generator samples a single weight, k > 1 needs type 0 or 3.");
+    }
+    if (multiplicity < 1) {
+      throw std::invalid_argument("Multiplicity must be greater than 0.");
+    }
+    static const std::vector<std::string> classes = {"uncorrelated", "weak", "strong", "inverse", "almost", "subset-sum"};
+    if (std::find(classes.begin(), classes.end(), correlation_class) == classes.end()) {
+      throw std::invalid_argument("Invalid class. Must be uncorrelated, weak, strong, inverse, almost or subset-sum.");
+    }
+    if (correlation_class != "uncorrelated" && type != 0 && type != 3) {
+      throw std::invalid_argument("Correlation classes are only available for random and bounded instances (type 0 or 3).");
+    }
+    if (sampler != "r" && sampler != "native") {
+      throw std::invalid_argument("Invalid sampler. Must be r or native.");
+    }
+    if (class_noise > 1.0) {
+      throw std::invalid_argument("Class noise must be at most 1.0.");
+    }
     if (timeout <= 0.0) {
       throw std::invalid_argument("Timeout must be greater than 0.0.");
     }
     if (weight_factor < 0.0 || weight_factor > 1.0) {
       throw std::invalid_argument("Weight factor must be between 0.0 and 1.0.");
     }
+    if (external_memory <= 0) {
+      throw std::invalid_argument("External memory must be greater than 0.");
+    }
+    if (external_items < 1 || external_items > 16) {
+      throw std::invalid_argument("External items must be between 1 and 16.");
+    }
+    // A pass merges 2^items streams, each with an 8 MiB buffer, plus three more buffers.
+    const int64_t buffer_memory = ((int64_t(1) << external_items) + 3) * 8;
+    if (!external_dir.empty() && m >= 3 && external_memory <= buffer_memory) {
+      throw std::invalid_argument("--external-items=" + std::to_string(external_items) + " needs " +
+                                  std::to_string(buffer_memory) + " MiB of I/O buffers, which do not fit in --external-memory=" +
+                                  std::to_string(external_memory) + ".");
+    }
+    if (algorithm != "mobkp" && algorithm != "layered" && algorithm != "many" && algorithm != "bnb" &&
+        algorithm != "core") {
+      throw std::invalid_argument("Invalid algorithm. Must be mobkp, layered, many, bnb or core.");
+    }
+    if (algorithm == "bnb" && (!stats.empty() || !stream.empty() || !save_snapshot.empty() || !extend_from.empty() ||
+                               (!external_dir.empty() && m >= 3))) {
+      throw std::invalid_argument("The branch and bound has no DP layers, it cannot be combined with --stats, --stream, "
+                                  "--save-snapshot, --extend-from or --external-dir.");
+    }
+    if (algorithm == "core" && (m != 2 || k != 1)) {
+      throw std::invalid_argument("The core solver needs m=2 and k=1.");
+    }
+    if (algorithm == "core" && (!stats.empty() || !stream.empty() || !save_snapshot.empty() || !extend_from.empty() ||
+                                presolve > 0.0)) {
+      throw std::invalid_argument("The core solver runs several DPs over changing items, it cannot be combined with "
+                                  "--stats, --stream, --save-snapshot, --extend-from or --presolve.");
+    }
+    if (threads <= 0) {
+      throw std::invalid_argument("Threads must be greater than 0.");
+    }
+    if (!stats.empty() && stats != "json" && stats != "csv") {
+      throw std::invalid_argument("Invalid stats format. Must be json or csv.");
+    }
+    if (!stats.empty() && algorithm == "mobkp" && k == 1 && stream.empty() && save_snapshot.empty() && extend_from.empty() && presolve == 0.0 && (external_dir.empty() || m < 3)) {
+      throw std::invalid_argument("Stats are only recorded by the native engines (layered, many or external-memory DP).");
+    }
+    if (!stream.empty() && !external_dir.empty() && m >= 3) {
+      throw std::invalid_argument("Streaming needs the layers in memory, it is not available with the external-memory DP.");
+    }
+    if ((!save_snapshot.empty() || !extend_from.empty()) && !external_dir.empty() && m >= 3) {
+      throw std::invalid_argument("Snapshots need the layers in memory, they are not available with the external-memory DP.");
+    }
+    if (presolve < 0.0) {
+      throw std::invalid_argument("Presolve budget must be non-negative.");
+    }
+    if (presolve > 0.0 && !external_dir.empty() && m >= 3) {
+      throw std::invalid_argument("The presolve prunes layers in memory, it is not available with the external-memory DP.");
+    }
+    if (presolve > 0.0 && !save_snapshot.empty()) {
+      throw std::invalid_argument("A presolved layer lacks states needed to extend the instance, --presolve cannot be "
+                                  "combined with --save-snapshot.");
+    }
+    if (huge_pages != "off" && huge_pages != "thp" && huge_pages != "hugetlb") {
+      throw std::invalid_argument("Invalid huge pages mode. Must be off, thp or hugetlb.");
+    }
+    if (progress < 0.0) {
+      throw std::invalid_argument("Progress interval must be non-negative.");
+    }
+    if (!status_file.empty() && progress == 0.0) {
+      progress = 10.0;
+    }
+    if (estimate < 0.0) {
+      throw std::invalid_argument("Estimate budget must be non-negative.");
+    }
+    if (target_front < 0) {
+      throw std::invalid_argument("Target front size must be non-negative.");
+    }
+    if (search != "n" && search != "weight-factor" && search != "correlation") {
+      throw std::invalid_argument("Invalid search parameter. Must be n, weight-factor or correlation.");
+    }
+    if (target_front > 0 && search == "correlation" && type != 1 && type != 2) {
+      throw std::invalid_argument("A search on the correlation needs a correlated instance (type 1 or 2).");
+    }
+#ifndef MOBKP_TRACE
+    if (!trace.empty()) {
+      throw std::invalid_argument("Tracing is not compiled in, build with -DMOBKP_TRACE=ON.");
+    }
+#endif
     folder_path = create_folder_path();
     if (folder_path.empty()) {
       throw std::runtime_error("Folder path is empty.");
@@ -141,19 +498,56 @@ class Arguments {
   }
 
   std::string create_folder_path() {
-    static const std::string folder_types[] = {"random/", "neg_corr/", "pos_corr/"};
+    static const std::string folder_types[] = {"random/", "neg_corr/", "pos_corr/", "bounded/"};
     std::string path = "../instances/";
-    if (type >= 0 && type < 3) {
+    if (type >= 0 && type < 4) {
       path += folder_types[type];
     }
-    path += std::to_string(m) + "D/";
+    path += std::to_string(m) + "D" + (k > 1 ? "_" + std::to_string(k) + "K" : "") + "/";
     return path;
   }
 
   std::string create_outfile() {
+    if (correlation_class != "uncorrelated") {
+      return std::to_string(n) + "_" + std::to_string(seed) + "_" + correlation_class + ".in";
+    }
     return std::to_string(n) + "_" + std::to_string(seed) +
-           (type == 0 ? ".in" : "_" + std::to_string(correlation) + ".in");
+           (type == 0 || type == 3 ? ".in" : "_" + std::to_string(correlation) + ".in");
   }
 };
 
+// Arguments of a job given as a line of mobkp-instances options.
+std::unique_ptr<Arguments> parse_arguments_line(const std::string &line) {
+  std::vector<std::string> tokens = {"mobkp-instances"};
+  std::istringstream ss(line);
+  std::string token;
+  while (ss >> token) {
+    tokens.push_back(token);
+  }
+  std::vector<char *> argv;
+  for (auto &t : tokens) {
+    argv.push_back(t.data());
+  }
+  argv.push_back(nullptr);
+  return std::make_unique<Arguments>(static_cast<int>(tokens.size()), argv.data());
+}
+
+std::unique_ptr<Arguments> Arguments::with_option(const std::string &key, const std::string &value) const {
+  return with_options({{key, value}});
+}
+
+std::unique_ptr<Arguments> Arguments::with_options(const std::vector<std::pair<std::string, std::string>> &changes) const {
+  std::string line;
+  for (auto const &option : options) {
+    const auto key = option.substr(0, option.find('='));
+    if (std::none_of(changes.begin(), changes.end(), [&](auto const &change) { return change.first == key; })) {
+      line += option + " ";
+    }
+  }
+  for (auto const &change : changes) {
+    line += change.first + "=" + change.second + " ";
+  }
+  return parse_arguments_line(line);
+}
+
 #endif  // PARSER_HPP
@@ -0,0 +1,588 @@
+#ifndef PRESOLVE_HPP
+#define PRESOLVE_HPP
+
+#include <algorithm>
+#include <chrono>
+#include <cstdint>
+#include <functional>
+#include <limits>
+#include <numeric>
+#include <random>
+#include <thread>
+#include <utility>
+#include <vector>
+
+#include <pages.hpp>
+#include <trace.hpp>
+
+// Heuristic lower-bound set and bound-based pruning of the native DPs.
+//
+// The presolve packs the knapsack greedily for several weighted sums of the
+// objectives (the unit vectors, the uniform one and random ones) and improves
+// each packing by local search on that weighted sum, adding items that fit and
+// swapping a packed item for a better one. Every packing found is a feasible
+// solution, and the non-dominated ones form the lower-bound set L.
+//
+// After each item, the optimistic completion U(s) of a state s adds to its
+// values, per objective, the smallest over the constraints of the fractional
+// knapsack bound of the remaining items within the slack of s. When a point of
+// L is at least U(s) in every objective and differs from it, every completion
+// of s is strictly dominated by a feasible solution, so s is dropped. A state
+// leading to a point of the front is never dropped, and the front is exact.
+
+namespace presolve_detail {
+
+// Non-dominated points of a set, inserted one at a time.
+template <typename T>
+void archive_insert(std::vector<std::vector<T>> &archive, const std::vector<T> &p) {
+  auto covers = [](const std::vector<T> &a, const std::vector<T> &b) {
+    return std::equal(a.begin(), a.end(), b.begin(), [](T x, T y) { return x >= y; });
+  };
+  for (auto const &a : archive) {
+    if (covers(a, p)) {
+      return;
+    }
+  }
+  archive.erase(std::remove_if(archive.begin(), archive.end(), [&](auto const &a) { return covers(p, a); }),
+                archive.end());
+  archive.push_back(p);
+}
+
+}  // namespace presolve_detail
+
+// Approximate front of the problem found within `budget` seconds by `threads` threads.
+template <typename T, typename Problem>
+std::vector<std::vector<T>> presolve_front(const Problem &problem, double budget, size_t threads, uint64_t seed = 1) {
+  MOBKP_TRACE_SPAN("presolve", "solve");
+  using clock = std::chrono::steady_clock;
+  const auto deadline = clock::now() + std::chrono::duration_cast<clock::duration>(std::chrono::duration<double>(budget));
+  const size_t n = problem.num_items();
+  const size_t m = problem.num_objectives();
+  const size_t k = problem.num_constraints();
+  std::vector<T> values(n * m), weights(n * k), capacity(k);
+  for (size_t i = 0; i < n; ++i) {
+    auto v = problem.item_values(i);
+    auto w = problem.item_weights(i);
+    std::copy(v.begin(), v.end(), values.begin() + i * m);
+    std::copy(w.begin(), w.end(), weights.begin() + i * k);
+  }
+  for (size_t c = 0; c < k; ++c) {
+    capacity[c] = problem.weight_capacity(c);
+  }
+  // Directions beyond the m unit vectors and the uniform one are random, so the
+  // threads keep drawing new ones until the budget runs out.
+  const size_t max_directions = std::max<size_t>(m + 1, 64);
+
+  auto search = [&](size_t direction, std::vector<std::vector<T>> &archive) {
+    std::vector<double> lambda(m, 0.0);
+    if (direction < m) {
+      lambda[direction] = 1.0;
+    } else if (direction == m) {
+      std::fill(lambda.begin(), lambda.end(), 1.0);
+    } else {
+      auto rng = std::mt19937_64(seed * 1000003 + direction);
+      auto draw = std::exponential_distribution<double>(1.0);
+      for (auto &l : lambda) {
+        l = draw(rng);
+      }
+    }
+    std::vector<double> score(n);
+    for (size_t i = 0; i < n; ++i) {
+      score[i] = std::inner_product(lambda.begin(), lambda.end(), values.begin() + i * m, 0.0);
+    }
+
+    // Greedy by the weighted value per unit of relative weight.
+    std::vector<size_t> order(n);
+    std::iota(order.begin(), order.end(), 0);
+    std::vector<double> efficiency(n);
+    for (size_t i = 0; i < n; ++i) {
+      double load = 1e-9;
+      for (size_t c = 0; c < k; ++c) {
+        load += capacity[c] > 0 ? static_cast<double>(weights[i * k + c]) / capacity[c] : 0.0;
+      }
+      efficiency[i] = score[i] / load;
+    }
+    std::sort(order.begin(), order.end(), [&](size_t a, size_t b) { return efficiency[a] > efficiency[b]; });
+    std::vector<uint8_t> packed(n, 0);
+    std::vector<T> load(k, 0);
+    std::vector<T> total(m, 0);
+    auto fits = [&](size_t i, size_t removed) {
+      for (size_t c = 0; c < k; ++c) {
+        const T base = removed < n ? load[c] - weights[removed * k + c] : load[c];
+        if (base + weights[i * k + c] > capacity[c]) {
+          return false;
+        }
+      }
+      return true;
+    };
+    auto flip = [&](size_t i) {
+      const T sign = packed[i] ? -1 : 1;
+      packed[i] = !packed[i];
+      for (size_t c = 0; c < k; ++c) {
+        load[c] += sign * weights[i * k + c];
+      }
+      for (size_t j = 0; j < m; ++j) {
+        total[j] += sign * values[i * m + j];
+      }
+    };
+    for (auto i : order) {
+      if (fits(i, n)) {
+        flip(i);
+      }
+    }
+    presolve_detail::archive_insert(archive, total);
+
+    // Local search: add an item that fits, or swap a packed item for a better one.
+    bool improved = true;
+    while (improved && clock::now() < deadline) {
+      improved = false;
+      for (size_t b = 0; b < n && !improved; ++b) {
+        if (!packed[b] && fits(b, n)) {
+          flip(b);
+          improved = true;
+        }
+      }
+      for (size_t a = 0; a < n && !improved; ++a) {
+        if (!packed[a]) {
+          continue;
+        }
+        for (size_t b = 0; b < n && !improved; ++b) {
+          if (!packed[b] && score[b] > score[a] && fits(b, a)) {
+            flip(a);
+            flip(b);
+            improved = true;
+          }
+        }
+      }
+      if (improved) {
+        presolve_detail::archive_insert(archive, total);
+      }
+    }
+  };
+
+  threads = std::max<size_t>(1, threads);
+  std::vector<std::vector<std::vector<T>>> archives(threads);
+  auto run = [&](size_t t) {
+    for (size_t direction = t; direction < max_directions && clock::now() < deadline; direction += threads) {
+      search(direction, archives[t]);
+    }
+  };
+  if (threads == 1) {
+    run(0);
+  } else {
+    std::vector<std::thread> pool;
+    for (size_t t = 0; t < threads; ++t) {
+      pool.emplace_back(run, t);
+    }
+    for (auto &worker : pool) {
+      worker.join();
+    }
+  }
+  std::vector<std::vector<T>> front;
+  for (auto const &archive : archives) {
+    for (auto const &p : archive) {
+      presolve_detail::archive_insert(front, p);
+    }
+  }
+  return front;
+}
+
+template <typename T>
+class bound_pruner {
+ public:
+  template <typename Problem>
+  bound_pruner(const Problem &problem, std::vector<std::vector<T>> lower)
+      : n(problem.num_items()), m(problem.num_objectives()), k(problem.num_constraints()), capacity(k),
+        values(n * m), weights(n * k), lower(std::move(lower)) {
+    for (size_t c = 0; c < k; ++c) {
+      capacity[c] = problem.weight_capacity(c);
+    }
+    for (size_t i = 0; i < n; ++i) {
+      auto v = problem.item_values(i);
+      auto w = problem.item_weights(i);
+      std::copy(v.begin(), v.end(), values.begin() + i * m);
+      std::copy(w.begin(), w.end(), weights.begin() + i * k);
+    }
+    ratio_order.resize(m * k);
+    for (size_t j = 0; j < m; ++j) {
+      for (size_t c = 0; c < k; ++c) {
+        auto &items = ratio_order[j * k + c];
+        items.resize(n);
+        std::iota(items.begin(), items.end(), 0);
+        std::sort(items.begin(), items.end(), [&](size_t a, size_t b) {
+          return values[a * m + j] * weights[b * k + c] > values[b * m + j] * weights[a * k + c];
+        });
+      }
+    }
+    // The points of largest sum come first, a point can only cover a bound of smaller sum.
+    std::sort(this->lower.begin(), this->lower.end(), [](auto const &a, auto const &b) {
+      return std::accumulate(a.begin(), a.end(), T(0)) > std::accumulate(b.begin(), b.end(), T(0));
+    });
+    for (auto const &p : this->lower) {
+      lower_sum.push_back(std::accumulate(p.begin(), p.end(), T(0)));
+    }
+  }
+
+  size_t lower_size() const { return lower.size(); }
+
+  // Drops the states of the layer after the first `done` items whose
+  // optimistic completion is strictly dominated by a point of the lower set.
+  // Returns the number of states dropped.
+  size_t prune(size_t done, state_vector<T> &layer) {
+    MOBKP_TRACE_SPAN("prune", "dp");
+    if (lower.empty()) {
+      return 0;
+    }
+    prepare(done);
+    const size_t width = m + k;
+    std::vector<T> bound(m);
+    size_t kept = 0;
+    for (size_t s = 0; s < layer.size(); s += width) {
+      const T *state = layer.data() + s;
+      T bound_sum = 0;
+      for (size_t j = 0; j < m; ++j) {
+        T gain = suffix_value[j];
+        for (size_t c = 0; c < k && gain > 0; ++c) {
+          gain = std::min(gain, fractional_bound(j, c, capacity[c] - state[m + c]));
+        }
+        bound[j] = state[j] + gain;
+        bound_sum += bound[j];
+      }
+      bool covered = false;
+      for (size_t l = 0; l < lower.size() && lower_sum[l] > bound_sum && !covered; ++l) {
+        covered = std::equal(bound.begin(), bound.end(), lower[l].begin(), [](T u, T p) { return p >= u; });
+      }
+      if (!covered) {
+        std::copy(state, state + width, layer.data() + kept);
+        kept += width;
+      }
+    }
+    const size_t dropped = (layer.size() - kept) / width;
+    layer.resize(kept);
+    return dropped;
+  }
+
+ private:
+  size_t n, m, k;
+  std::vector<T> capacity;
+  std::vector<T> values;
+  std::vector<T> weights;
+  std::vector<std::vector<T>> lower;
+  std::vector<T> lower_sum;
+
+  // Per objective j and constraint c, the items by decreasing value to weight
+  // ratio, the remaining ones in that order and the prefix sums of their
+  // weights and values.
+  std::vector<std::vector<size_t>> ratio_order;
+  std::vector<std::vector<size_t>> order;
+  std::vector<std::vector<T>> prefix_weight, prefix_value;
+  std::vector<T> suffix_value;
+
+  void prepare(size_t done) {
+    order.assign(m * k, {});
+    prefix_weight.assign(m * k, {});
+    prefix_value.assign(m * k, {});
+    suffix_value.assign(m, 0);
+    for (size_t i = done; i < n; ++i) {
+      for (size_t j = 0; j < m; ++j) {
+        suffix_value[j] += values[i * m + j];
+      }
+    }
+    for (size_t j = 0; j < m; ++j) {
+      for (size_t c = 0; c < k; ++c) {
+        auto &items = order[j * k + c];
+        for (auto i : ratio_order[j * k + c]) {
+          if (i >= done) {
+            items.push_back(i);
+          }
+        }
+        auto &pw = prefix_weight[j * k + c];
+        auto &pv = prefix_value[j * k + c];
+        pw.assign(1, 0);
+        pv.assign(1, 0);
+        for (auto i : items) {
+          pw.push_back(pw.back() + weights[i * k + c]);
+          pv.push_back(pv.back() + values[i * m + j]);
+        }
+      }
+    }
+  }
+
+  // Largest value of objective j the remaining items add within `slack` of
+  // constraint c when they may be taken fractionally.
+  T fractional_bound(size_t j, size_t c, T slack) const {
+    const auto &pw = prefix_weight[j * k + c];
+    const auto &pv = prefix_value[j * k + c];
+    // Items [0, whole) fit entirely.
+    const size_t whole = std::upper_bound(pw.begin(), pw.end(), slack) - pw.begin() - 1;
+    T bound = pv[whole];
+    if (whole + 1 < pw.size()) {
+      const size_t next = order[j * k + c][whole];
+      const T w = weights[next * k + c];
+      if (w > 0) {
+        bound += values[next * m + j] * (slack - pw[whole]) / w;
+      }
+    }
+    return bound;
+  }
+};
+
+// Bound-set pruning of bi-objective, single-constraint DPs.
+//
+// The completions of a state s = (v, w) reach at most the polygon of the
+// weighted LP bounds l.g <= B(l, slack) over a few weightings l: the two
+// objectives and the normals of the edges between the supported points of the
+// lower set L, which follow the shape of the front. A point not weakly
+// dominated by L is at least one of the local upper points of L, (f_a.1 + 1,
+// f_a+1.2 + 1) for consecutive points sorted by the first objective. When each
+// of them that the completions could reach is cut off by one of the bounds,
+// every completion of s is weakly dominated by L, and s is dropped. The points
+// of L must be added to the front of the pruned DP.
+template <typename T>
+class bound_set_pruner {
+ public:
+  template <typename Problem>
+  bound_set_pruner(const Problem &problem, std::vector<std::vector<T>> lower)
+      : n(problem.num_items()), capacity(problem.weight_capacity(0)), value1(n), value2(n), weight(n) {
+    for (size_t i = 0; i < n; ++i) {
+      auto v = problem.item_values(i);
+      value1[i] = v[0];
+      value2[i] = v[1];
+      weight[i] = problem.item_weights(i)[0];
+    }
+    set_lower(std::move(lower));
+  }
+
+  // Replaces the lower set; its points need not be mutually non-dominated.
+  void set_lower(std::vector<std::vector<T>> lower) {
+    std::vector<std::vector<T>> front;
+    for (auto const &p : lower) {
+      presolve_detail::archive_insert(front, p);
+    }
+    std::sort(front.begin(), front.end());
+    upper1.clear();
+    upper2.clear();
+    weightings.clear();
+    prepared = n + 1;
+    if (front.empty()) {
+      return;
+    }
+    const T lowest = std::numeric_limits<T>::lowest();
+    for (size_t a = 0; a <= front.size(); ++a) {
+      upper1.push_back(a == 0 ? lowest : front[a - 1][0] + 1);
+      upper2.push_back(a == front.size() ? lowest : front[a][1] + 1);
+    }
+    add_weighting(1, 0);
+    add_weighting(0, 1);
+    // Normals of the upper convex hull edges, at most max_weightings of them spread along the hull.
+    std::vector<const std::vector<T> *> hull;
+    for (auto const &p : front) {
+      while (hull.size() >= 2) {
+        const auto &a = *hull[hull.size() - 2];
+        const auto &b = *hull.back();
+        if ((b[0] - a[0]) * (p[1] - a[1]) - (b[1] - a[1]) * (p[0] - a[0]) < 0) {
+          break;
+        }
+        hull.pop_back();
+      }
+      hull.push_back(&p);
+    }
+    const size_t edges = hull.size() - 1;
+    const size_t step = std::max<size_t>(1, (edges + max_weightings - 1) / max_weightings);
+    for (size_t h = 1; h < hull.size(); h += step) {
+      const T l1 = (*hull[h - 1])[1] - (*hull[h])[1];
+      const T l2 = (*hull[h])[0] - (*hull[h - 1])[0];
+      const T g = std::gcd(l1, l2);
+      if (l1 > 0 && l2 > 0) {
+        add_weighting(l1 / g, l2 / g);
+      }
+    }
+    // The two end points have a coordinate of lowest() and are never scanned by blocks.
+    const size_t blocks = (upper1.size() + block - 1) / block;
+    for (size_t w = 2; w < weightings.size(); ++w) {
+      auto &l = weightings[w];
+      l.block_min.assign(blocks, std::numeric_limits<T>::max());
+      for (size_t a = 1; a + 1 < upper1.size(); ++a) {
+        l.block_min[a / block] = std::min(l.block_min[a / block], l.l1 * upper1[a] + l.l2 * upper2[a]);
+      }
+    }
+  }
+
+  // Builds the bounds of the items from `done` on.
+  void prepare(size_t done) {
+    if (done == prepared) {
+      return;
+    }
+    prepared = done;
+    for (auto &l : weightings) {
+      l.remaining.clear();
+      l.prefix_weight.assign(1, 0);
+      l.prefix_value.assign(1, 0);
+      for (auto i : l.order) {
+        if (i >= done) {
+          l.remaining.push_back(i);
+          l.prefix_weight.push_back(l.prefix_weight.back() + weight[i]);
+          l.prefix_value.push_back(l.prefix_value.back() + weighted(l, i));
+        }
+      }
+    }
+  }
+
+  // Drops the states of the layer after the first `done` items that are
+  // covered. Returns the number of states dropped.
+  size_t prune(size_t done, state_vector<T> &layer) {
+    MOBKP_TRACE_SPAN("prune", "dp");
+    if (upper1.empty()) {
+      return 0;
+    }
+    prepare(done);
+    // The states are sorted by weight, so the slack only decreases and the
+    // items that fit entirely in each order are found by moving cursors.
+    std::vector<size_t> whole(weightings.size());
+    for (size_t w = 0; w < weightings.size(); ++w) {
+      whole[w] = weightings[w].remaining.size();
+    }
+    size_t kept = 0;
+    for (size_t s = 0; s < layer.size(); s += 3) {
+      const T *state = layer.data() + s;
+      const T slack = capacity - state[2];
+      auto bound_of = [&](size_t w) {
+        const auto &pw = weightings[w].prefix_weight;
+        while (pw[whole[w]] > slack) {
+          --whole[w];
+        }
+        return bound(weightings[w], slack, whole[w]);
+      };
+      if (!covered_within(state[0], state[1], bound_of)) {
+        std::copy(state, state + 3, layer.data() + kept);
+        kept += 3;
+      }
+    }
+    const size_t dropped = (layer.size() - kept) / 3;
+    layer.resize(kept);
+    return dropped;
+  }
+
+ private:
+  static constexpr size_t max_weightings = 16;
+  static constexpr size_t block = 16;
+
+  // A weighting of the objectives, the items by decreasing weighted
+  // efficiency, and the prepared ones in that order with their prefix sums.
+  struct weighting {
+    T l1, l2;
+    std::vector<size_t> order;
+    std::vector<size_t> remaining;
+    std::vector<T> prefix_weight;
+    std::vector<T> prefix_value;
+    std::vector<T> block_min;  // minimum weighted upper point of each block of them
+  };
+
+  size_t n;
+  T capacity;
+  std::vector<T> value1, value2, weight;
+  // Local upper points of the lower set, the first coordinate increasing and the second decreasing.
+  std::vector<T> upper1, upper2;
+  std::vector<weighting> weightings;  // the two objectives first
+  size_t prepared = 0;
+  std::vector<T> limits;  // scratch space of covered_within()
+  size_t hint = 0;        // upper point reached by the last state kept
+  size_t cut = 0;         // hull weighting that cut off the last upper point
+
+  T weighted(const weighting &l, size_t i) const { return l.l1 * value1[i] + l.l2 * value2[i]; }
+
+  void add_weighting(T l1, T l2) {
+    auto l = weighting{l1, l2, std::vector<size_t>(n), {}, {}, {}, {}};
+    std::iota(l.order.begin(), l.order.end(), 0);
+    std::sort(l.order.begin(), l.order.end(),
+              [&](size_t a, size_t b) { return weighted(l, a) * weight[b] > weighted(l, b) * weight[a]; });
+    weightings.push_back(std::move(l));
+  }
+
+  // LP bound of the weighted value the prepared items add within `slack`,
+  // when the first `whole` of them fit entirely.
+  T bound(const weighting &l, T slack, size_t whole) const {
+    T value = l.prefix_value[whole];
+    if (whole < l.remaining.size() && weight[l.remaining[whole]] > 0) {
+      value += weighted(l, l.remaining[whole]) * (slack - l.prefix_weight[whole]) / weight[l.remaining[whole]];
+    }
+    return value;
+  }
+
+  // `bound_of(w)` gives the LP bound of weighting w for the state.
+  template <typename BoundOf>
+  bool covered_within(T v1, T v2, BoundOf &&bound_of) {
+    const T gain1 = bound_of(0);
+    const T gain2 = bound_of(1);
+    // The upper points within reach end before the first one beyond v1 + gain1,
+    // and start after the last one beyond v2 + gain2.
+    const size_t last = std::upper_bound(upper1.begin(), upper1.end(), v1 + gain1) - upper1.begin();
+    if (last == 0 || upper2[last - 1] > v2 + gain2) {
+      return true;
+    }
+    const size_t first =
+        std::partition_point(upper2.begin(), upper2.begin() + last, [&](T u2) { return u2 > v2 + gain2; }) -
+        upper2.begin();
+    // Weighting w cuts off an upper point u when its weighted gain
+    // l1 * d1 + l2 * d2 over the state exceeds the bound of the state.
+    limits.resize(weightings.size());
+    for (size_t w = 2; w < weightings.size(); ++w) {
+      limits[w] = bound_of(w) + weightings[w].l1 * v1 + weightings[w].l2 * v2;
+    }
+    // Returns the weighting cutting off upper point u, or 0 if it is reached.
+    // Neighbouring upper points tend to be cut off by the same weighting.
+    const size_t count = weightings.size() - 2;
+    auto cut_by = [&](size_t u) -> size_t {
+      const T u1 = std::max(upper1[u], v1);
+      const T u2 = std::max(upper2[u], v2);
+      for (size_t tried = 0, w = cut; tried < count; ++tried, w = w + 1 == count ? 0 : w + 1) {
+        if (weightings[w + 2].l1 * u1 + weightings[w + 2].l2 * u2 > limits[w + 2]) {
+          cut = w;
+          return w + 2;
+        }
+      }
+      return 0;
+    };
+    // Consecutive states tend to reach the same upper point.
+    if (first <= hint && hint < last && cut_by(hint) == 0) {
+      return false;
+    }
+    // Before `low` the gain in the first objective is 0 and after `high` the
+    // gain in the second is, so of those only the points next to the range
+    // [low, high) can be reached first.
+    const size_t low = std::lower_bound(upper1.begin() + first, upper1.begin() + last, v1) - upper1.begin();
+    const size_t high =
+        std::partition_point(upper2.begin() + low, upper2.begin() + last, [&](T u2) { return u2 >= v2; }) -
+        upper2.begin();
+    for (size_t u : {low - 1, high}) {
+      if (first <= u && u < last && cut_by(u) == 0) {
+        hint = u;
+        return false;
+      }
+    }
+    // Within the range the weighted gains are linear in the upper points, so
+    // whole blocks cut off by one weighting are skipped at once.
+    for (size_t u = low; u < high;) {
+      const size_t w = cut_by(u);
+      if (w == 0) {
+        hint = u;
+        return false;
+      }
+      const auto &l = weightings[w];
+      auto cut_off = [&](size_t a) { return l.l1 * upper1[a] + l.l2 * upper2[a] > limits[w]; };
+      for (++u; u < high && u % block != 0 && cut_off(u); ++u) {
+      }
+      if (u < high && u % block == 0) {
+        while (u + block <= high && l.block_min[u / block] > limits[w]) {
+          u += block;
+        }
+        while (u < high && cut_off(u)) {
+          ++u;
+        }
+      }
+    }
+    return true;
+  }
+};
+
+#endif  // PRESOLVE_HPP
@@ -0,0 +1,258 @@
+#ifndef PROGRESS_HPP
+#define PROGRESS_HPP
+
+#include <unistd.h>
+
+#include <fmt/core.h>
+#include <fmt/ostream.h>
+
+#include <algorithm>
+#include <atomic>
+#include <chrono>
+#include <cmath>
+#include <condition_variable>
+#include <cstdio>
+#include <filesystem>
+#include <fstream>
+#include <mutex>
+#include <stdexcept>
+#include <string>
+#include <thread>
+#include <utility>
+#include <vector>
+
+// Live progress of a solve. The DP writes a few counters with relaxed atomic
+// stores once per layer and a heartbeat thread reads them periodically, so
+// the hot loop never takes a lock. An observer may also set `cancelled` to
+// stop a native solve at the end of the current layer, through request_cancel
+// so that a solve already in an engine that cannot stop is not reported as
+// cancelled.
+
+// How a solve ended, recorded by solve_mobkp before the final report.
+enum class solve_outcome { running, done, timed_out, cancelled, failed };
+
+struct progress_counters {
+  std::atomic<size_t> items{0};            // items of the instance
+  std::atomic<size_t> layers_done{0};      // items already processed, 0 when unknown
+  std::atomic<size_t> states{0};           // states of the last layer
+  std::atomic<size_t> previous_states{0};  // states of the layer before it
+  std::atomic<size_t> peak_states{0};      // states of the largest layer
+  std::atomic<size_t> total_states{0};     // states of all the layers
+  std::atomic<double> layer_seconds{0.0};  // time taken by the last layer
+  std::atomic<double> eta_seconds{-1.0};   // fitted time of the remaining layers, negative while unknown
+  std::atomic<bool> cancelled{false};      // set by request_cancel to stop the solve
+  std::atomic<solve_outcome> outcome{solve_outcome::running};
+
+  // Asks the solve to stop. False when it already runs an engine that cannot.
+  bool request_cancel() {
+    std::lock_guard<std::mutex> lock(cancel_mutex);
+    if (uncancellable) {
+      return false;
+    }
+    cancelled.store(true);
+    return true;
+  }
+
+  // Called before an engine that cannot stop early. False when the solve was
+  // cancelled before it started.
+  bool enter_uncancellable() {
+    std::lock_guard<std::mutex> lock(cancel_mutex);
+    if (cancelled.load()) {
+      return false;
+    }
+    uncancellable = true;
+    return true;
+  }
+
+ private:
+  std::mutex cancel_mutex;
+  bool uncancellable = false;
+};
+
+struct solve_cancelled : std::runtime_error {
+  solve_cancelled() : std::runtime_error("Solve cancelled") {}
+};
+
+// Stats policy that publishes the progress and forwards to another policy.
+template <typename Stats>
+class progress_stats {
+ public:
+  static constexpr bool enabled = Stats::enabled;
+
+  progress_stats(Stats &inner, progress_counters &counters) : inner(inner), counters(counters) {}
+
+  void begin_layer(size_t item, size_t states) {
+    start = std::chrono::steady_clock::now();
+    current_item = item;
+    inner.begin_layer(item, states);
+  }
+  void candidate() { inner.candidate(); }
+  void capacity_rejection() { inner.capacity_rejection(); }
+  void capacity_rejections(size_t count) { inner.capacity_rejections(count); }
+  void dominance_test() { inner.dominance_test(); }
+  void dominance_tests(size_t count) { inner.dominance_tests(count); }
+  void bound_rejections(size_t count) { inner.bound_rejections(count); }
+  void end_layer(size_t states, size_t bytes) {
+    inner.end_layer(states, bytes);
+    const double seconds = std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count();
+    counters.previous_states.store(counters.states.load(std::memory_order_relaxed), std::memory_order_relaxed);
+    counters.states.store(states, std::memory_order_relaxed);
+    if (states > counters.peak_states.load(std::memory_order_relaxed)) {
+      counters.peak_states.store(states, std::memory_order_relaxed);
+    }
+    counters.total_states.fetch_add(states, std::memory_order_relaxed);
+    counters.layer_seconds.store(seconds, std::memory_order_relaxed);
+    counters.layers_done.store(current_item + 1, std::memory_order_relaxed);
+    history.emplace_back(current_item + 1, seconds);
+    counters.eta_seconds.store(fit_remaining(), std::memory_order_relaxed);
+    if (counters.cancelled.load(std::memory_order_relaxed)) {
+      throw solve_cancelled();
+    }
+  }
+
+ private:
+  Stats &inner;
+  progress_counters &counters;
+  size_t current_item = 0;
+  std::chrono::steady_clock::time_point start;
+  std::vector<std::pair<size_t, double>> history;  // items done and time of each layer
+
+  // Fewest layers the remaining time is extrapolated from.
+  static constexpr size_t min_fit_layers = 8;
+
+  // Remaining time from a power law t = a * i^b of the layer time against the
+  // items done, fitted by least squares in log-log space over the later half
+  // of the layers (the first ones are dominated by fixed costs) and summed
+  // over the layers left. Negative while fewer than min_fit_layers are done.
+  double fit_remaining() const {
+    if (history.size() < min_fit_layers) {
+      return -1.0;
+    }
+    double sx = 0.0, sy = 0.0, sxx = 0.0, sxy = 0.0;
+    const size_t first = history.size() / 2;
+    const double count = static_cast<double>(history.size() - first);
+    for (size_t j = first; j < history.size(); ++j) {
+      const double x = std::log(static_cast<double>(history[j].first));
+      const double y = std::log(std::max(history[j].second, 1e-7));
+      sx += x;
+      sy += y;
+      sxx += x * x;
+      sxy += x * y;
+    }
+    const double denominator = count * sxx - sx * sx;
+    const double exponent = denominator > 0.0 ? (count * sxy - sx * sy) / denominator : 0.0;
+    const double intercept = (sy - exponent * sx) / count;
+    double remaining = 0.0;
+    const size_t items = counters.items.load(std::memory_order_relaxed);
+    for (size_t i = history.back().first + 1; i <= items; ++i) {
+      remaining += std::exp(intercept + exponent * std::log(static_cast<double>(i)));
+    }
+    return remaining;
+  }
+};
+
+// Resident set size of the process in KiB.
+int64_t current_rss_kb() {
+  auto statm = std::ifstream("/proc/self/statm");
+  int64_t size = 0, resident = 0;
+  if (!(statm >> size >> resident)) {
+    return 0;
+  }
+  return resident * (::sysconf(_SC_PAGESIZE) / 1024);
+}
+
+// Heartbeat thread reporting the progress every `interval` seconds to stderr,
+// or to `status_file` (rewritten atomically) when one is given.
+class progress_reporter {
+ public:
+  progress_reporter(const progress_counters &counters, double interval, std::string status_file)
+      : counters(counters), interval(interval), status_file(std::move(status_file)) {
+    start = std::chrono::steady_clock::now();
+    thread = std::thread([this]() { run(); });
+  }
+  ~progress_reporter() {
+    {
+      std::lock_guard<std::mutex> lock(mutex);
+      stopping = true;
+    }
+    cv.notify_all();
+    thread.join();
+    report(true);
+  }
+  progress_reporter(const progress_reporter &) = delete;
+  progress_reporter &operator=(const progress_reporter &) = delete;
+
+ private:
+  const progress_counters &counters;
+  double interval;
+  std::string status_file;
+  std::chrono::steady_clock::time_point start;
+  std::mutex mutex;
+  std::condition_variable cv;
+  bool stopping = false;
+  std::thread thread;
+
+  void run() {
+    std::unique_lock<std::mutex> lock(mutex);
+    while (!cv.wait_for(lock, std::chrono::duration<double>(interval), [this]() { return stopping; })) {
+      report(false);
+    }
+  }
+
+  // Status of the solve. The final report says done only when the solve
+  // returned normally and, for an engine with layer progress, after its last layer.
+  const char *status(bool finished, size_t items, size_t done) const {
+    if (!finished) {
+      return "running";
+    }
+    switch (counters.outcome.load()) {
+      case solve_outcome::done:
+        return done == 0 || done >= items ? "done" : "timeout";
+      case solve_outcome::timed_out:
+        return "timeout";
+      case solve_outcome::cancelled:
+        return "cancelled";
+      default:
+        return "error";
+    }
+  }
+
+  void report(bool finished) {
+    const double elapsed = std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count();
+    const size_t items = counters.items.load(std::memory_order_relaxed);
+    const size_t done = counters.layers_done.load(std::memory_order_relaxed);
+    const size_t states = counters.states.load(std::memory_order_relaxed);
+    const size_t previous = counters.previous_states.load(std::memory_order_relaxed);
+    const double growth = previous > 0 ? std::max(1.0, static_cast<double>(states) / previous) : 1.0;
+    const int64_t rss_kb = current_rss_kb();
+
+    const char *state = status(finished, items, done);
+    const double eta = counters.eta_seconds.load(std::memory_order_relaxed);
+
+    std::string line;
+    if (done == 0) {
+      line = fmt::format("status={} elapsed={:.1f} rss_kb={}", state, elapsed, rss_kb);
+    } else {
+      const std::string eta_text = std::string(state) == "done" ? "0.0"
+                                   : eta < 0.0                  ? "unknown"
+                                                                : fmt::format("{:.1f}", eta);
+      line = fmt::format("status={} layer={} layers={} states={} growth={:.4f} rss_kb={} elapsed={:.1f} eta={}", state,
+                         done, items, states, growth, rss_kb, elapsed, eta_text);
+    }
+
+    if (status_file.empty()) {
+      fmt::print(stderr, "[progress] {}\n", line);
+      return;
+    }
+    // Replace the status file atomically so a poller never sees a partial line.
+    const std::string tmp_path = status_file + ".tmp";
+    {
+      auto out = std::ofstream(tmp_path);
+      fmt::print(out, "{}\n", line);
+    }
+    std::error_code ec;
+    std::filesystem::rename(tmp_path, status_file, ec);
+  }
+};
+
+#endif  // PROGRESS_HPP
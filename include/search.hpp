@@ -0,0 +1,185 @@
+#ifndef SEARCH_HPP
+#define SEARCH_HPP
+
+#include <fmt/core.h>
+
+#include <algorithm>
+#include <cmath>
+#include <memory>
+#include <stdexcept>
+#include <string>
+
+#include <estimate.hpp>
+#include <parser.hpp>
+#include <solver.hpp>
+
+// Search for an instance with a front of a target size.
+//
+// Candidates differ in one parameter (n, the weight factor or the correlation)
+// and are scored by the front size that estimate_solve predicts from small
+// sub-instances, so no candidate is solved in full. The parameter is
+// bracketed and bisected on the log of the predicted size, assuming the front
+// grows (or shrinks) monotonically with it over the searched range, and only
+// the chosen candidate is generated again and solved.
+
+class front_search {
+ public:
+  explicit front_search(const Arguments &args)
+      : base(args.with_option("--seed", std::to_string(args.get_seed()))),
+        goal(std::log(static_cast<double>(args.get_target_front()))),
+        budget(args.get_estimate() > 0.0 ? args.get_estimate() : 0.5) {}
+
+  // Returns the chosen value of the parameter.
+  double run() {
+    const auto &parameter = base->get_search();
+    if (parameter == "n") {
+      search_n();
+    } else if (parameter == "weight-factor") {
+      search_range(0.01, 0.5);
+    } else if (base->get_type() == 1) {
+      // The Pearson correlation 2 sin(pi/6 rho) of the sampler must stay above
+      // -1/(m-1) for the correlation matrix to be positive definite.
+      const double pi = std::acos(-1.0);
+      search_range(0.99 * 6 / pi * std::asin(-1.0 / (2 * (base->get_m() - 1))), -0.01);
+    } else {
+      search_range(0.01, 0.99 / (base->get_m() - 1));
+    }
+    return best;
+  }
+
+  // Solves the chosen candidate and writes it to the library.
+  void solve_best() {
+    const auto args = candidate(best)->with_option("--estimate", "0");
+    fmt::print("[search] solving {}={} (predicted front {:.0f})\n", base->get_search(), format_value(best),
+               std::exp(best_prediction));
+    auto problem_solutions = solve_mobkp(*args, generate_points(*args));
+    write_solution(args->get_folder_path(), args->get_outfile(), problem_solutions.first, problem_solutions.second,
+                   generate_multiplicities(*args));
+    fmt::print("[search] {}{}: front of {} points for a target of {}\n", args->get_folder_path(), args->get_outfile(),
+               problem_solutions.second.size(), base->get_target_front());
+  }
+
+ private:
+  static constexpr double tolerance = 0.0953;  // log(1.1), a candidate within 10% of the target is taken
+  static constexpr int max_steps = 16;
+  static constexpr double max_n = 1 << 20;
+
+  std::unique_ptr<Arguments> base;
+  double goal;
+  double budget;
+  double best = 0.0;
+  double best_prediction = 0.0;
+  bool has_best = false;
+
+  std::string format_value(double x) const {
+    return base->get_search() == "n" ? std::to_string(std::llround(x)) : fmt::format("{:.4f}", x);
+  }
+
+  std::unique_ptr<Arguments> candidate(double x) const {
+    return base->with_option("--" + base->get_search(), format_value(x));
+  }
+
+  // Log of the predicted front size of the candidate, or NaN when the candidate
+  // cannot be generated or sampled, which is reported and skipped.
+  double predict(double x) {
+    auto estimate = solve_estimate{};
+    try {
+      const auto args = candidate(x);
+      estimate = estimate_solve(*args, generate_points(*args), budget);
+    } catch (const std::exception &e) {
+      fmt::print("[search] {}={}: skipped, {}\n", base->get_search(), format_value(x), e.what());
+      return std::nan("");
+    }
+    const double prediction = std::log(std::max(1.0, estimate.front_size.value));
+    fmt::print("[search] {}={}: predicted front {:.0f} [{:.0f}, {:.0f}]\n", base->get_search(), format_value(x),
+               estimate.front_size.value, estimate.front_size.low, estimate.front_size.high);
+    if (!has_best || std::abs(prediction - goal) < std::abs(best_prediction - goal)) {
+      best = x;
+      best_prediction = prediction;
+      has_best = true;
+    }
+    return prediction;
+  }
+
+  bool close_enough() const { return std::abs(best_prediction - goal) < tolerance; }
+
+  // Brackets n by doubling or halving from the given n, then bisects it. The
+  // search stops at a skipped candidate, keeping the closest one so far.
+  void search_n() {
+    double x = base->get_n();
+    double f = predict(x);
+    if (std::isnan(f)) {
+      throw std::runtime_error("The instance of the given n cannot be sampled.");
+    }
+    double a = x, fa = f, b = x, fb = f;
+    if (f < goal) {
+      while (f < goal && !close_enough()) {
+        if (x >= max_n) {
+          throw std::runtime_error("No instance with up to 2^20 items reaches the target front size.");
+        }
+        a = x, fa = f;
+        x = std::min(max_n, 2 * x);
+        f = predict(x);
+      }
+      if (std::isnan(f)) {
+        return;
+      }
+      b = x, fb = f;
+    } else {
+      while (f >= goal && x > 2 && !close_enough()) {
+        b = x, fb = f;
+        x = std::max(2.0, std::floor(x / 2));
+        f = predict(x);
+      }
+      if (std::isnan(f)) {
+        return;
+      }
+      a = x, fa = f;
+    }
+    bisect(a, fa, b, fb, true);
+  }
+
+  // Bisects a bounded range, keeping the closest end when the target lies
+  // outside. An end whose candidate is skipped is moved halfway to the other end.
+  void search_range(double a, double b) {
+    double fa = predict(a);
+    double fb = predict(b);
+    for (int step = 0; step < max_steps && (std::isnan(fa) || std::isnan(fb)); ++step) {
+      if (std::isnan(fa)) {
+        a = (a + b) / 2;
+        fa = predict(a);
+      } else {
+        b = (a + b) / 2;
+        fb = predict(b);
+      }
+    }
+    if (std::isnan(fa) || std::isnan(fb)) {
+      throw std::runtime_error("No candidate of the searched range can be sampled.");
+    }
+    if ((goal - fa) * (goal - fb) > 0.0) {
+      fmt::print("[search] the target is outside the predictions of the range, keeping the closest end\n");
+      return;
+    }
+    bisect(a, fa, b, fb, false);
+  }
+
+  void bisect(double a, double fa, double b, double fb, bool integral) {
+    for (int step = 0; step < max_steps && !close_enough(); ++step) {
+      if (integral && b - a <= 1) {
+        break;
+      }
+      const double mid = integral ? std::floor((a + b) / 2) : (a + b) / 2;
+      const double fm = predict(mid);
+      if (std::isnan(fm)) {
+        break;
+      }
+      if ((fm < goal) == (fa < fb)) {
+        a = mid, fa = fm;
+      } else {
+        b = mid, fb = fm;
+      }
+    }
+  }
+};
+
+#endif  // SEARCH_HPP
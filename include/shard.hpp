@@ -0,0 +1,259 @@
+#ifndef SHARD_HPP
+#define SHARD_HPP
+
+#include <fcntl.h>
+#include <sys/stat.h>
+#include <unistd.h>
+
+#include <fmt/core.h>
+#include <fmt/ostream.h>
+
+#include <atomic>
+#include <cerrno>
+#include <chrono>
+#include <condition_variable>
+#include <filesystem>
+#include <fstream>
+#include <mutex>
+#include <stdexcept>
+#include <string>
+#include <thread>
+#include <vector>
+
+#include <parser.hpp>
+#include <solver.hpp>
+
+// Sharded generation over a shared filesystem.
+//
+// Workers on one or many hosts share a directory holding the job list
+// (jobs.txt, one line of mobkp-instances options per job) and claim jobs
+// through lease files:
+//
+//   leases/<id>  claimed by a worker, its mtime is refreshed by a heartbeat
+//   done/<id>    the instance was written
+//   failed/<id>  the job threw, with the error message
+//
+// A lease is taken by hard-linking a private file to leases/<id>, which is
+// atomic on local filesystems and NFS alike. A lease whose mtime is older
+// than the expiry belongs to a crashed worker: it is renamed away (only one
+// worker wins the rename) and the job is claimed again. Ages are measured
+// against the clock of the file server, read from the mtime of a probe file,
+// so the hosts' clocks do not need to agree.
+
+class shard_directory {
+ public:
+  shard_directory(const std::string &path, double expiry) : root(path), expiry(expiry) {
+    char host[256] = {};
+    ::gethostname(host, sizeof(host) - 1);
+    owner = fmt::format("{}.{}", host, ::getpid());
+    for (auto const *sub : {"leases", "done", "failed", "tmp"}) {
+      std::filesystem::create_directories(root / sub);
+    }
+  }
+
+  const std::string &owner_id() const { return owner; }
+
+  std::vector<std::string> read_jobs() const {
+    auto in = std::ifstream(root / "jobs.txt");
+    if (!in.is_open()) {
+      throw std::runtime_error("Could not open file " + (root / "jobs.txt").string());
+    }
+    std::vector<std::string> jobs;
+    std::string line;
+    while (std::getline(in, line)) {
+      const auto first = line.find_first_not_of(" \t");
+      if (first != std::string::npos && line[first] != '#') {
+        jobs.push_back(line);
+      }
+    }
+    return jobs;
+  }
+
+  bool finished(size_t id) const {
+    return std::filesystem::exists(root / "done" / key(id)) || std::filesystem::exists(root / "failed" / key(id));
+  }
+
+  // Claims job `id`, taking over its lease when it has expired.
+  bool claim(size_t id) {
+    const auto lease = lease_path(id);
+    const auto mine = root / "tmp" / (key(id) + "." + owner);
+    {
+      auto out = std::ofstream(mine);
+      fmt::print(out, "{}\n", owner);
+    }
+    bool claimed = ::link(mine.c_str(), lease.c_str()) == 0;
+    if (!claimed && errno == EEXIST && expired(lease)) {
+      const auto stale = root / "tmp" / (key(id) + ".stale." + owner);
+      if (::rename(lease.c_str(), stale.c_str()) == 0) {
+        if (expired(stale)) {
+          fmt::print(stderr, "[shard] job {}: lease of {} expired, claiming it again\n", id, read_owner(stale));
+          claimed = ::link(mine.c_str(), lease.c_str()) == 0;
+        } else {
+          // Another worker renewed the lease between the check and the rename, give it back.
+          ::link(stale.c_str(), lease.c_str());
+        }
+        std::filesystem::remove(stale);
+      }
+    }
+    std::filesystem::remove(mine);
+    // A finished job may have been released between the check and the link.
+    if (claimed && finished(id)) {
+      release(id);
+      return false;
+    }
+    return claimed;
+  }
+
+  // Refreshes the lease; false when another worker took it over.
+  bool heartbeat(size_t id) const {
+    const auto lease = lease_path(id);
+    if (read_owner(lease) != owner) {
+      return false;
+    }
+    return ::utimensat(AT_FDCWD, lease.c_str(), nullptr, 0) == 0;
+  }
+
+  void complete(size_t id, const std::string &error) {
+    auto out = std::ofstream(root / (error.empty() ? "done" : "failed") / key(id));
+    fmt::print(out, "{}\n{}\n", owner, error);
+    out.close();
+    release(id);
+  }
+
+  void release(size_t id) {
+    if (read_owner(lease_path(id)) == owner) {
+      std::filesystem::remove(lease_path(id));
+    }
+  }
+
+ private:
+  std::filesystem::path root;
+  double expiry;
+  std::string owner;
+
+  static std::string key(size_t id) { return std::to_string(id); }
+  std::filesystem::path lease_path(size_t id) const { return root / "leases" / key(id); }
+
+  static std::string read_owner(const std::filesystem::path &path) {
+    auto in = std::ifstream(path);
+    std::string id;
+    in >> id;
+    return id;
+  }
+
+  // Current time of the file server, from the mtime of a freshly touched file.
+  double server_now() const {
+    const auto probe = root / "tmp" / ("clock." + owner);
+    {
+      auto out = std::ofstream(probe);
+    }
+    const double now = mtime(probe);
+    std::filesystem::remove(probe);
+    return now;
+  }
+
+  static double mtime(const std::filesystem::path &path) {
+    struct stat st;
+    if (::stat(path.c_str(), &st) != 0) {
+      return 0.0;
+    }
+    return st.st_mtim.tv_sec + st.st_mtim.tv_nsec / 1e9;
+  }
+
+  bool expired(const std::filesystem::path &lease) const {
+    const double modified = mtime(lease);
+    return modified > 0.0 && server_now() - modified > expiry;
+  }
+};
+
+// Refreshes the lease of a running job until it is destroyed.
+class lease_heartbeat {
+ public:
+  lease_heartbeat(const shard_directory &shard, size_t id, double interval) : shard(shard), id(id), interval(interval) {
+    thread = std::thread([this]() { run(); });
+  }
+  ~lease_heartbeat() {
+    {
+      std::lock_guard<std::mutex> lock(mutex);
+      stopping = true;
+    }
+    cv.notify_all();
+    thread.join();
+  }
+  lease_heartbeat(const lease_heartbeat &) = delete;
+  lease_heartbeat &operator=(const lease_heartbeat &) = delete;
+
+ private:
+  const shard_directory &shard;
+  size_t id;
+  double interval;
+  std::mutex mutex;
+  std::condition_variable cv;
+  bool stopping = false;
+  std::atomic<bool> lease_lost = false;
+  std::thread thread;
+
+  void run() {
+    std::unique_lock<std::mutex> lock(mutex);
+    while (!cv.wait_for(lock, std::chrono::duration<double>(interval), [this]() { return stopping; })) {
+      if (!shard.heartbeat(id) && !lease_lost.exchange(true)) {
+        fmt::print(stderr, "[shard] job {}: lease lost to another worker\n", id);
+      }
+    }
+  }
+};
+
+// Solves one job and writes its instance atomically, so two workers racing
+// on a re-claimed job never leave a partial file. The R generator of type 1
+// and 2 jobs writes to a temporary file of its own (see generate_corr_points),
+// never to the instance path.
+void run_shard_job(const Arguments &args, const std::string &owner) {
+  if (args.get_estimate() > 0.0) {
+    solve_and_write(args, generate_points(args));
+    return;
+  }
+  auto problem_solutions = solve_mobkp(args, generate_points(args));
+  const auto tmp_file = args.get_outfile() + "." + owner + ".tmp";
+  write_solution(args.get_folder_path(), tmp_file, problem_solutions.first, problem_solutions.second,
+                 generate_multiplicities(args));
+  std::filesystem::rename(args.get_folder_path() + tmp_file, args.get_folder_path() + args.get_outfile());
+}
+
+// Claims and runs jobs until every job of the shard directory is finished.
+void run_shard_worker(const Arguments &args) {
+  auto shard = shard_directory(args.get_shard_dir(), args.get_lease_expiry());
+  const auto jobs = shard.read_jobs();
+  size_t completed = 0;
+  while (true) {
+    bool pending = false;
+    for (size_t id = 0; id < jobs.size(); ++id) {
+      if (shard.finished(id)) {
+        continue;
+      }
+      if (!shard.claim(id)) {
+        pending = true;  // running elsewhere, retried once its lease may have expired
+        continue;
+      }
+      fmt::print("[shard] job {}: claimed by {} ({})\n", id, shard.owner_id(), jobs[id]);
+      std::string error;
+      {
+        auto heartbeat = lease_heartbeat(shard, id, args.get_heartbeat());
+        try {
+          run_shard_job(*parse_arguments_line(jobs[id]), shard.owner_id());
+        } catch (const std::exception &e) {
+          error = e.what();
+        }
+      }
+      shard.complete(id, error);
+      ++completed;
+      fmt::print("[shard] job {}: {}\n", id, error.empty() ? "done" : "failed: " + error);
+    }
+    if (!pending) {
+      break;
+    }
+    std::this_thread::sleep_for(std::chrono::duration<double>(args.get_heartbeat()));
+  }
+  fmt::print("[shard] {} ran {} of {} jobs\n", shard.owner_id(), completed, jobs.size());
+}
+
+#endif  // SHARD_HPP
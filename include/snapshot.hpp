@@ -0,0 +1,205 @@
+#ifndef SNAPSHOT_HPP
+#define SNAPSHOT_HPP
+
+#include <cstdint>
+#include <cstdio>
+#include <cstring>
+#include <fstream>
+#include <iterator>
+#include <stdexcept>
+#include <string>
+#include <type_traits>
+#include <utility>
+#include <vector>
+
+#include <pages.hpp>
+
+// Final DP layer of a solve, to extend the instance with more items later.
+//
+// A snapshot holds the states (m objective values followed by k weights) left
+// after the first `items` items at fixed capacities, with a checksum of those
+// items so that it is only applied to an instance that starts with them. The
+// states are sorted by total weight, so each column is stored as zigzag
+// varint deltas from the previous state, which is a few bytes per value.
+//
+//   "MOBKPSNP" version m k items checksum    header, fixed-width little endian
+//   capacities                               k int64
+//   states                                   uint64 count, then the varints
+
+template <typename T>
+struct dp_snapshot {
+  size_t m = 0;
+  size_t k = 0;
+  size_t items = 0;
+  uint64_t checksum = 0;
+  std::vector<T> capacity;
+  state_vector<T> layer;
+};
+
+// FNV-1a hash of the coefficients (m values and k weights) of the first `items` items.
+template <typename Problem>
+uint64_t items_checksum(const Problem &problem, size_t items) {
+  uint64_t hash = 14695981039346656037ull;
+  auto mix = [&hash](int64_t value) {
+    for (size_t b = 0; b < sizeof(value); ++b) {
+      hash = (hash ^ ((static_cast<uint64_t>(value) >> (8 * b)) & 0xff)) * 1099511628211ull;
+    }
+  };
+  for (size_t i = 0; i < items; ++i) {
+    for (auto v : problem.item_values(i)) {
+      mix(v);
+    }
+    for (auto w : problem.item_weights(i)) {
+      mix(w);
+    }
+  }
+  return hash;
+}
+
+namespace snapshot_detail {
+
+constexpr char magic[8] = {'M', 'O', 'B', 'K', 'P', 'S', 'N', 'P'};
+constexpr uint32_t version = 1;
+
+inline void put_fixed(std::string &out, uint64_t value, size_t bytes) {
+  for (size_t b = 0; b < bytes; ++b) {
+    out.push_back(static_cast<char>((value >> (8 * b)) & 0xff));
+  }
+}
+
+inline void put_varint(std::string &out, int64_t value) {
+  uint64_t zigzag = (static_cast<uint64_t>(value) << 1) ^ static_cast<uint64_t>(value >> 63);
+  while (zigzag >= 0x80) {
+    out.push_back(static_cast<char>((zigzag & 0x7f) | 0x80));
+    zigzag >>= 7;
+  }
+  out.push_back(static_cast<char>(zigzag));
+}
+
+class reader {
+ public:
+  reader(std::string data, const std::string &path) : data(std::move(data)), path(path) {}
+
+  uint64_t fixed(size_t bytes) {
+    need(bytes);
+    uint64_t value = 0;
+    for (size_t b = 0; b < bytes; ++b) {
+      value |= static_cast<uint64_t>(static_cast<unsigned char>(data[pos++])) << (8 * b);
+    }
+    return value;
+  }
+
+  int64_t varint() {
+    uint64_t zigzag = 0;
+    for (size_t shift = 0;; shift += 7) {
+      need(1);
+      if (shift > 63) {
+        fail();
+      }
+      const auto byte = static_cast<unsigned char>(data[pos++]);
+      zigzag |= static_cast<uint64_t>(byte & 0x7f) << shift;
+      if ((byte & 0x80) == 0) {
+        break;
+      }
+    }
+    return static_cast<int64_t>(zigzag >> 1) ^ -static_cast<int64_t>(zigzag & 1);
+  }
+
+  bool starts_with(const char *prefix, size_t bytes) {
+    need(bytes);
+    pos += bytes;
+    return std::memcmp(data.data(), prefix, bytes) == 0;
+  }
+
+  bool done() const { return pos == data.size(); }
+
+ private:
+  std::string data;
+  const std::string &path;
+  size_t pos = 0;
+
+  void need(size_t bytes) const {
+    if (data.size() - pos < bytes) {
+      fail();
+    }
+  }
+  [[noreturn]] void fail() const { throw std::runtime_error("Corrupt snapshot file " + path); }
+};
+
+}  // namespace snapshot_detail
+
+template <typename T>
+void write_snapshot(const std::string &path, const dp_snapshot<T> &snapshot) {
+  static_assert(std::is_integral<T>::value && sizeof(T) <= sizeof(int64_t), "Snapshots store integer states");
+  using namespace snapshot_detail;
+  const size_t width = snapshot.m + snapshot.k;
+  std::string out(magic, sizeof(magic));
+  put_fixed(out, version, 4);
+  put_fixed(out, snapshot.m, 4);
+  put_fixed(out, snapshot.k, 4);
+  put_fixed(out, snapshot.items, 8);
+  put_fixed(out, snapshot.checksum, 8);
+  for (auto c : snapshot.capacity) {
+    put_fixed(out, static_cast<uint64_t>(c), 8);
+  }
+  const size_t states = snapshot.layer.size() / width;
+  put_fixed(out, states, 8);
+  out.reserve(out.size() + snapshot.layer.size() * 2);
+  std::vector<T> previous(width, 0);
+  for (size_t s = 0; s < states; ++s) {
+    const T *state = snapshot.layer.data() + s * width;
+    for (size_t j = 0; j < width; ++j) {
+      put_varint(out, static_cast<int64_t>(state[j]) - static_cast<int64_t>(previous[j]));
+      previous[j] = state[j];
+    }
+  }
+
+  // Written next to the target and renamed, so a reader never sees half a snapshot.
+  const std::string tmp_path = path + ".tmp";
+  {
+    auto file = std::ofstream(tmp_path, std::ios::binary | std::ios::trunc);
+    if (!file.write(out.data(), static_cast<std::streamsize>(out.size()))) {
+      throw std::runtime_error("Could not write snapshot file " + tmp_path);
+    }
+  }
+  if (std::rename(tmp_path.c_str(), path.c_str()) != 0) {
+    throw std::runtime_error("Could not rename snapshot file to " + path);
+  }
+}
+
+template <typename T>
+dp_snapshot<T> read_snapshot(const std::string &path) {
+  using namespace snapshot_detail;
+  auto file = std::ifstream(path, std::ios::binary);
+  if (!file.is_open()) {
+    throw std::runtime_error("Could not open snapshot file " + path);
+  }
+  auto in = reader(std::string(std::istreambuf_iterator<char>(file), std::istreambuf_iterator<char>()), path);
+  if (!in.starts_with(magic, sizeof(magic)) || in.fixed(4) != version) {
+    throw std::runtime_error("Not a snapshot file of this version: " + path);
+  }
+  auto snapshot = dp_snapshot<T>{};
+  snapshot.m = in.fixed(4);
+  snapshot.k = in.fixed(4);
+  snapshot.items = in.fixed(8);
+  snapshot.checksum = in.fixed(8);
+  for (size_t c = 0; c < snapshot.k; ++c) {
+    snapshot.capacity.push_back(static_cast<T>(in.fixed(8)));
+  }
+  const size_t width = snapshot.m + snapshot.k;
+  const size_t states = in.fixed(8);
+  snapshot.layer.reserve(states * width);
+  std::vector<int64_t> previous(width, 0);
+  for (size_t s = 0; s < states; ++s) {
+    for (size_t j = 0; j < width; ++j) {
+      previous[j] += in.varint();
+      snapshot.layer.push_back(static_cast<T>(previous[j]));
+    }
+  }
+  if (!in.done()) {
+    throw std::runtime_error("Corrupt snapshot file " + path);
+  }
+  return snapshot;
+}
+
+#endif  // SNAPSHOT_HPP
@@ -1,10 +1,26 @@
 #ifndef SOLVER_HPP
 #define SOLVER_HPP
 
+#include <unistd.h>
+
 #include <fmt/core.h>
 #include <fmt/ranges.h>
 
 #include <boost/multiprecision/cpp_int.hpp>
+#include <bnb.hpp>
+#include <core.hpp>
+#include <correlated.hpp>
+#include <estimate.hpp>
+#include <external_dp.hpp>
+#include <layered_dp.hpp>
+#include <many_dp.hpp>
+#include <pages.hpp>
+#include <presolve.hpp>
+#include <progress.hpp>
+#include <snapshot.hpp>
+#include <stats.hpp>
+#include <stream.hpp>
+#include <trace.hpp>
 #include <filesystem>
 #include <fstream>
 #include <mobkp/anytime_trace.hpp>
@@ -14,6 +30,7 @@
 #include <mobkp/solution.hpp>
 #include <mooutils/indicators.hpp>
 #include <random>
+#include <thread>
 #include <vector>
 
 using data_type = int_fast64_t;
@@ -24,93 +41,538 @@ using hv_data_type = boost::multiprecision::int256_t;
 using problem_type = mobkp::ordered_problem<mobkp::problem<data_type>>;
 using solution_type = mobkp::solution<problem_type, dvec_type, ovec_type, cvec_type>;
 
+// Single-constraint instances keep the original format; with k > 1 constraints
+// the header is "n m k", followed by the k capacities and, for each item, its
+// k weights and m values. Bounded instances have a "n m k U" header, U the
+// largest multiplicity, and the multiplicity of each item before its weights.
+void write_instance(std::ostream &solution_stream, const mobkp::problem<data_type> &problem,
+                    const std::vector<ovec_type> &front, const std::vector<int64_t> &multiplicities = {}) {
+  const size_t k = problem.num_constraints();
+  if (!multiplicities.empty()) {
+    fmt::print(solution_stream, "{} {} {} {}\n", problem.num_items(), problem.num_objectives(), k,
+               *std::max_element(multiplicities.begin(), multiplicities.end()));
+    std::vector<data_type> capacities(k);
+    for (size_t j = 0; j < k; ++j) {
+      capacities[j] = problem.weight_capacity(j);
+    }
+    fmt::print(solution_stream, "{:d}\n", fmt::join(capacities, " "));
+    for (size_t i = 0; i < problem.num_items(); ++i) {
+      fmt::print(solution_stream, "{} {:d} {:d}\n", multiplicities[i], fmt::join(problem.item_weights(i), " "),
+                 fmt::join(problem.item_values(i), " "));
+    }
+  } else if (k == 1) {
+    fmt::print(solution_stream, "{} {}\n", problem.num_items(), problem.num_objectives());
+    fmt::print(solution_stream, "{}\n", problem.weight_capacity(0));
+    for (size_t i = 0; i < problem.num_items(); ++i) {
+      fmt::print(solution_stream, "{} {:d}\n", problem.item_weights(i).back(), fmt::join(problem.item_values(i), " "));
+    }
+  } else {
+    fmt::print(solution_stream, "{} {} {}\n", problem.num_items(), problem.num_objectives(), k);
+    std::vector<data_type> capacities(k);
+    for (size_t j = 0; j < k; ++j) {
+      capacities[j] = problem.weight_capacity(j);
+    }
+    fmt::print(solution_stream, "{:d}\n", fmt::join(capacities, " "));
+    for (size_t i = 0; i < problem.num_items(); ++i) {
+      fmt::print(solution_stream, "{:d} {:d}\n", fmt::join(problem.item_weights(i), " "),
+                 fmt::join(problem.item_values(i), " "));
+    }
+  }
+  fmt::print(solution_stream, "{}\n", front.size());
+  for (auto const &p : front) {
+    fmt::print(solution_stream, "{:d}\n", fmt::join(p, " "));
+  }
+}
+
 void write_solution(const std::string &folder_path, const std::string &file_name,
-                    const mobkp::problem<data_type> &problem, const mooutils::unordered_set<solution_type> &solutions) {
+                    const mobkp::problem<data_type> &problem, const std::vector<ovec_type> &front,
+                    const std::vector<int64_t> &multiplicities = {}) {
+  MOBKP_TRACE_SPAN("write_solution", "io");
   if (!std::filesystem::exists(folder_path)) {
-    std::filesystem::create_directory(folder_path);
+    std::filesystem::create_directories(folder_path);
   }
   const std::string file_path = folder_path + file_name; // TODO: Verify this / is correct
   // std::cout << "Saving solution to: " << file_path << std::endl;
   auto solution_stream = std::ofstream(file_path);
-  fmt::print(solution_stream, "{} {}\n", problem.num_items(), problem.num_objectives());
-  fmt::print(solution_stream, "{}\n", problem.weight_capacity(0));
-  for (size_t i = 0; i < problem.num_items(); ++i) {
-    fmt::print(solution_stream, "{} {:d}\n", problem.item_weights(i).back(), fmt::join(problem.item_values(i), " "));
-  }
-  fmt::print(solution_stream, "{}\n", solutions.size());
-  for (auto const &s : solutions) {
-    fmt::print(solution_stream, "{:d}\n", fmt::join(s.objective_vector(), " "));
-  }
+  write_instance(solution_stream, problem, front, multiplicities);
   solution_stream.close();
 }
 
-auto solve_mobkp(const Arguments &args, std::vector<data_type> points) {
-  const double timeout = args.get_timeout();
-  const int32_t n = args.get_n();
-  const int32_t m = args.get_m();
+// Options of a single solve. They are kept apart from the command line so
+// that drivers other than the generator (e.g. the benchmark) can solve too.
+struct solver_config {
+  double timeout = 604800.0;
+  std::string external_dir;
+  int64_t external_memory = 1024;
+  int32_t external_items = 1;
+  std::string algorithm = "mobkp";
+  size_t threads = 1;  // of the many-objective DP, the branch and bound and the presolve
+  std::string stats_format;
+  std::string stats_file;  // per-layer report of the native engines, none when empty
+  double progress_interval = 0.0;  // seconds between progress reports, none when 0
+  std::string status_file;         // progress goes to stderr when empty
+  progress_counters *counters = nullptr;  // published progress for an outside observer, optional
+  std::string huge_pages = "off";  // page backing of the native engines' state arrays
+  bool prefault = false;
+  std::string stream_file;  // final points are written here during the solve, none when empty
+  std::string snapshot_file;  // the final DP layer is saved here, none when empty
+  std::string extend_from;    // snapshot of the first items to resume from, none when empty
+  double presolve = 0.0;      // seconds of the heuristic lower-bound presolve, none when 0
 
-  const auto orig_problem = mobkp::problem<data_type>(n, m, 1, std::move(points));
+  static solver_config from_arguments(const Arguments &args) {
+    auto config = solver_config{};
+    config.timeout = args.get_timeout();
+    config.external_dir = args.get_external_dir();
+    config.external_memory = args.get_external_memory();
+    config.external_items = args.get_external_items();
+    config.algorithm = args.get_algorithm();
+    config.threads = args.get_threads();
+    if (!args.get_stats().empty()) {
+      config.stats_format = args.get_stats();
+      config.stats_file = args.get_folder_path() + args.get_outfile() + ".stats." + config.stats_format;
+    }
+    config.progress_interval = args.get_progress();
+    config.status_file = args.get_status_file();
+    config.huge_pages = args.get_huge_pages();
+    config.prefault = args.get_prefault();
+    config.stream_file = args.get_stream();
+    config.snapshot_file = args.get_save_snapshot();
+    config.extend_from = args.get_extend_from();
+    config.presolve = args.get_presolve();
+    return config;
+  }
+};
+
+// Solves with the engine chosen by `config`, publishing its progress in `counters`.
+auto solve_with_engine(const solver_config &config, const int32_t n, const int32_t m, const int32_t k,
+                       std::vector<data_type> points, progress_counters &counters) {
+  const double timeout = config.timeout;
+
+  auto hooks = dp_hooks<data_type>{};
+  uint64_t start_checksum = 0;
+  if (!config.extend_from.empty()) {
+    auto snapshot = read_snapshot<data_type>(config.extend_from);
+    if (snapshot.m != static_cast<size_t>(m) || snapshot.k != static_cast<size_t>(k) ||
+        snapshot.items > static_cast<size_t>(n)) {
+      throw std::runtime_error(fmt::format("Snapshot {} of {} items with m={} k={} does not fit the instance.",
+                                           config.extend_from, snapshot.items, snapshot.m, snapshot.k));
+    }
+    std::copy(snapshot.capacity.begin(), snapshot.capacity.end(), points.begin());
+    hooks.resume.item = snapshot.items;
+    hooks.resume.layer = std::move(snapshot.layer);
+    start_checksum = snapshot.checksum;
+  }
+
+  const auto orig_problem = mobkp::problem<data_type>(n, m, k, std::move(points));
 
   std::vector<size_t> index_order(n);
   std::iota(index_order.begin(), index_order.end(), 0);
 
   const auto problem = problem_type(orig_problem, index_order);
+  if (!config.extend_from.empty() && items_checksum(problem, hooks.resume.item) != start_checksum) {
+    throw std::runtime_error("The instance does not start with the items of snapshot " + config.extend_from + ".");
+  }
+
+  const auto pages = scoped_page_policy(page_policy{parse_page_mode(config.huge_pages), config.prefault});
+  const bool external = m >= 3 && !config.external_dir.empty();
+  const bool streamed = !config.stream_file.empty();
+  const bool snapshots = !config.snapshot_file.empty() || !config.extend_from.empty();
+  const bool presolved = config.presolve > 0.0;
+  if (config.algorithm == "bnb") {
+    auto seed = std::vector<ovec_type>();
+    if (presolved) {
+      seed = presolve_front<data_type>(problem, config.presolve, config.threads);
+    }
+    return std::make_pair(orig_problem, bnb_solve<data_type>(problem, timeout, config.threads, seed, &counters));
+  }
+  if (config.algorithm == "core") {
+    return std::make_pair(orig_problem, core_dp<data_type>(problem, timeout, config.threads, counters, config.progress_interval > 0.0));
+  }
+  if (external || config.algorithm == "layered" || config.algorithm == "many" || k > 1 || streamed || snapshots ||
+      presolved) {
+    auto pruner = std::unique_ptr<bound_pruner<data_type>>();
+    if (presolved) {
+      pruner = std::make_unique<bound_pruner<data_type>>(
+          problem, presolve_front<data_type>(problem, config.presolve, config.threads));
+    }
+    auto tracker = std::unique_ptr<final_point_tracker<data_type>>();
+    auto stream = std::unique_ptr<front_stream>();
+    if (streamed) {
+      tracker = std::make_unique<final_point_tracker<data_type>>(problem);
+      stream = std::make_unique<front_stream>(config.stream_file, n, m);
+    }
+    auto save_snapshot = [&](const state_vector<data_type> &layer) {
+      MOBKP_TRACE_SPAN("snapshot", "io");
+      auto snapshot = dp_snapshot<data_type>{static_cast<size_t>(m), static_cast<size_t>(k), static_cast<size_t>(n),
+                                             items_checksum(problem, n), {}, layer};
+      for (int32_t c = 0; c < k; ++c) {
+        snapshot.capacity.push_back(problem.weight_capacity(c));
+      }
+      write_snapshot(config.snapshot_file, snapshot);
+    };
+    if (!config.snapshot_file.empty() && hooks.resume.item == static_cast<size_t>(n)) {
+      save_snapshot(hooks.resume.layer.empty() ? state_vector<data_type>(m + k, 0) : hooks.resume.layer);
+    }
+    size_t reached = hooks.resume.item;  // items done by the last observed layer
+    if (streamed || !config.snapshot_file.empty()) {
+      hooks.observe = [&](size_t done, const state_vector<data_type> &layer) {
+        reached = done;
+        if (streamed) {
+          MOBKP_TRACE_SPAN("stream", "io");
+          auto points = tracker->update(done, layer);
+          if (!points.empty()) {
+            stream->write(done, points);
+          }
+        }
+        if (!config.snapshot_file.empty() && done == static_cast<size_t>(n)) {
+          save_snapshot(layer);
+        }
+      };
+    }
+    auto solve_native = [&](auto &inner) {
+      auto stats = progress_stats(inner, counters);
+      if (presolved) {
+        hooks.prune = [&](size_t done, state_vector<data_type> &layer) {
+          stats.bound_rejections(pruner->prune(done, layer));
+        };
+      }
+      if (external) {
+        auto ext_config = external_dp_config{};
+        ext_config.directory = config.external_dir;
+        ext_config.memory_bytes = static_cast<size_t>(config.external_memory) << 20;
+        ext_config.items_per_pass = config.external_items;
+        return external_dp<data_type>(problem, ext_config, timeout, stats);
+      }
+      if (config.algorithm == "many") {
+        return many_dp<data_type>(problem, timeout, config.threads, stats, std::move(hooks));
+      }
+      return layered_dp<data_type>(problem, timeout, stats, std::move(hooks));
+    };
+    auto finish_outputs = [&](const std::vector<ovec_type> &front) {
+      const bool timed_out = reached < static_cast<size_t>(n);
+      if (streamed) {
+        stream->finish(tracker->remaining(front), timed_out);
+      }
+      if (!config.snapshot_file.empty() && timed_out) {
+        fmt::print(stderr, "[snapshot] {} not saved: the solve stopped after {} of {} items\n", config.snapshot_file,
+                   reached, n);
+      }
+    };
+    if (config.stats_file.empty()) {
+      auto stats = no_stats{};
+      auto front = solve_native(stats);
+      finish_outputs(front);
+      return std::make_pair(orig_problem, front);
+    }
+    auto stats = layer_stats{};
+    auto front = solve_native(stats);
+    finish_outputs(front);
+    const char *engine = external ? "external_dp" : config.algorithm == "many" ? "many_dp" : "layered_dp";
+    write_stats(config.stats_file, config.stats_format, engine, stats, front.size());
+    return std::make_pair(orig_problem, front);
+  }
+
+  if (!counters.enter_uncancellable()) {
+    throw solve_cancelled();  // the library engines can only be cancelled before they start
+  }
   auto solutions = mooutils::unordered_set<solution_type>();
   auto hvref = ovec_type(m, -1);
   auto anytime_trace = mobkp::anytime_trace(mooutils::incremental_hv<hv_data_type, ovec_type>(hvref));
   switch (m) {
-    case 2:
+    case 2: {
+      MOBKP_TRACE_SPAN("fpsv_dp", "dp");
       solutions = mobkp::fpsv_dp<solution_type>(problem, anytime_trace, timeout);
       break;
-    default:
+    }
+    default: {
+      MOBKP_TRACE_SPAN("bhv_dp", "dp");
       // solutions = mobkp::nemull_dp<solution_type>(problem, anytime_trace, timeout);
       solutions = mobkp::bhv_dp<solution_type>(problem, anytime_trace, timeout);
       break;
+    }
+  }
+  auto front = std::vector<ovec_type>();
+  front.reserve(solutions.size());
+  for (auto const &s : solutions) {
+    front.push_back(s.objective_vector());
+  }
+  return std::make_pair(orig_problem, front);
+}
+
+// `points` holds the k capacities, then the m values and k weights of each item.
+// Multi-constraint problems (k > 1), streamed and presolved solves and solves
+// that save or resume from a snapshot are always solved by a native engine. When resuming,
+// the capacities are those of the snapshot.
+//
+// The outcome is recorded in the counters before the final progress report: a
+// native engine that returns before its last layer timed out, and so did an
+// engine without layer progress that returns after the timeout.
+auto solve_mobkp(const solver_config &config, const int32_t n, const int32_t m, const int32_t k,
+                 std::vector<data_type> points) {
+  MOBKP_TRACE_SPAN("solve_mobkp", "solve");
+  auto local_counters = progress_counters{};
+  auto &counters = config.counters != nullptr ? *config.counters : local_counters;
+  counters.items = n;
+  auto reporter = std::unique_ptr<progress_reporter>();
+  if (config.progress_interval > 0.0) {
+    reporter = std::make_unique<progress_reporter>(counters, config.progress_interval, config.status_file);
+  }
+  const auto start = std::chrono::steady_clock::now();
+  try {
+    auto result = solve_with_engine(config, n, m, k, std::move(points), counters);
+    const size_t done = counters.layers_done.load();
+    const bool timed_out =
+        done > 0 ? done < counters.items.load()
+                 : std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count() >= config.timeout;
+    counters.outcome.store(timed_out ? solve_outcome::timed_out : solve_outcome::done);
+    return result;
+  } catch (const solve_cancelled &) {
+    counters.outcome.store(solve_outcome::cancelled);
+    throw;
+  } catch (...) {
+    counters.outcome.store(solve_outcome::failed);
+    throw;
+  }
+}
+
+// 0/1 items equivalent to a bounded instance by binary splitting: an item with
+// u copies becomes items of 1, 2, 4, ... copies and a remainder, whose subsets
+// take every count from 0 to u, so the front is unchanged with O(log u) items
+// per item instead of u.
+std::vector<data_type> split_bounded(const int32_t m, const int32_t k, const std::vector<data_type> &points,
+                                     const std::vector<int64_t> &multiplicities) {
+  const size_t stride = m + k;
+  std::vector<data_type> split(points.begin(), points.begin() + k);
+  for (size_t i = 0; i < multiplicities.size(); ++i) {
+    const data_type *item = points.data() + k + i * stride;
+    int64_t left = multiplicities[i];
+    for (int64_t copies = 1; left > 0; copies *= 2) {
+      const int64_t take = std::min(copies, left);
+      for (size_t j = 0; j < stride; ++j) {
+        split.push_back(item[j] * take);
+      }
+      left -= take;
+    }
+  }
+  return split;
+}
+
+// Solves a bounded instance, or a 0/1 one when `multiplicities` is empty. The
+// returned problem is the bounded one, as written to the instance file.
+auto solve_mobkp(const solver_config &config, const int32_t n, const int32_t m, const int32_t k,
+                 std::vector<data_type> points, const std::vector<int64_t> &multiplicities) {
+  if (multiplicities.empty()) {
+    return solve_mobkp(config, n, m, k, std::move(points));
+  }
+  auto split = split_bounded(m, k, points, multiplicities);
+  const int32_t split_n = static_cast<int32_t>((split.size() - k) / (m + k));
+  auto problem_solutions = solve_mobkp(config, split_n, m, k, std::move(split));
+  for (int32_t c = 0; c < k; ++c) {
+    points[c] = problem_solutions.first.weight_capacity(c);  // from a snapshot when extending
   }
-  return std::make_pair(orig_problem, solutions);
+  return std::make_pair(mobkp::problem<data_type>(n, m, k, std::move(points)), problem_solutions.second);
 }
 
-void generate_random_mobkp_test(const Arguments &args, const int32_t MAX = 300) {
+// Copies of each item of a bounded instance (type 3), uniform in [1, multiplicity].
+// They have their own generator, so the coefficients are those of the random
+// instance of the same seed. Empty for 0/1 instances.
+std::vector<int64_t> generate_multiplicities(const Arguments &args) {
+  if (args.get_type() != 3) {
+    return {};
+  }
+  auto rng = std::mt19937_64(args.get_seed());
+  auto copies = std::uniform_int_distribution<int64_t>(1, args.get_multiplicity());
+  std::vector<int64_t> multiplicities(args.get_n());
+  for (auto &u : multiplicities) {
+    u = copies(rng);
+  }
+  return multiplicities;
+}
+
+auto solve_mobkp(const Arguments &args, std::vector<data_type> points) {
+  return solve_mobkp(solver_config::from_arguments(args), args.get_n(), args.get_m(), args.get_k(), std::move(points),
+                     generate_multiplicities(args));
+}
+
+// Estimate of the solve of the generated points, bounded instances are sampled
+// from their split items.
+solve_estimate estimate_solve(const Arguments &args, const std::vector<data_type> &points, double budget) {
+  const auto multiplicities = generate_multiplicities(args);
+  if (multiplicities.empty()) {
+    return estimate_solve<data_type>(args.get_n(), args.get_m(), args.get_k(), points, args.get_weight_factor(), budget,
+                                     args.get_seed());
+  }
+  const auto split = split_bounded(args.get_m(), args.get_k(), points, multiplicities);
+  const int32_t split_n = static_cast<int32_t>((split.size() - args.get_k()) / (args.get_m() + args.get_k()));
+  return estimate_solve<data_type>(split_n, args.get_m(), args.get_k(), split, args.get_weight_factor(), budget,
+                                   args.get_seed());
+}
+
+void print_estimate(const solve_estimate &estimate) {
+  auto print_value = [](const char *name, const estimate_value &e, const char *unit) {
+    fmt::print("{}: {:.6g}{} [{:.6g}, {:.6g}]\n", name, e.value, unit, e.low, e.high);
+  };
+  fmt::print("estimate from {} sub-instances of up to {} items (95% prediction interval)\n", estimate.samples,
+             estimate.largest_sample);
+  print_value("front_size", estimate.front_size, "");
+  print_value("peak_states", estimate.peak_states, "");
+  print_value("memory", estimate.memory_bytes, " bytes");
+  print_value("runtime", estimate.runtime, " s");
+}
+
+// Solves the generated points and writes the instance, or only predicts the
+// cost of the solve when --estimate is given.
+void solve_and_write(const Arguments &args, std::vector<data_type> points) {
+  if (args.get_estimate() > 0.0) {
+    print_estimate(estimate_solve(args, points, args.get_estimate()));
+    return;
+  }
+  auto problem_solutions = solve_mobkp(args, std::move(points));
+  auto problem = problem_solutions.first;
+  auto front = problem_solutions.second;
+
+  write_solution(args.get_folder_path(), args.get_outfile(), problem, front, generate_multiplicities(args));
+}
+
+// Points of a random instance of a knapsack correlation class (Pisinger's
+// difficulty classes, with coefficients in [1, R]). The class sets the mean
+// profit of an item per objective from its first weight w:
+//
+//   weak        w + e, e in [-R/10, R/10]
+//   strong      w + R/10
+//   inverse     p uniform in [1, R], and w = p + R/10
+//   almost      w + R/10 + e, e in [-R/500, R/500]
+//   subset-sum  w
+//
+// and the m objectives share the item's total profit in a uniformly random
+// split, so they conflict while their sum follows the weight. --class-noise
+// replaces the width of e (as a fraction of R, added to w for inverse) to tune
+// the correlation. Any further weights are uniform in [1, R].
+std::vector<data_type> generate_class_points(const Arguments &args, const int32_t R = 1000) {
+  MOBKP_TRACE_SPAN("generate_class_points", "generate");
   const int32_t n = args.get_n();
   const int32_t m = args.get_m();
-  std::srand(args.get_seed());
+  const int32_t k = args.get_k();
+  const std::string &name = args.get_class();
+  double noise = name == "weak" ? 0.1 : name == "almost" ? 0.002 : 0.0;
+  if (args.get_class_noise() >= 0.0) {
+    noise = args.get_class_noise();
+  }
+  const int64_t offset = name == "strong" || name == "inverse" || name == "almost" ? R / 10 : 0;
+  const auto width = static_cast<int64_t>(std::round(noise * R));
 
-  std::vector<int64_t> points(n * (m + 1));
-  int64_t total_weight = 0;
+  auto rng = std::mt19937_64(args.get_seed());
+  auto coefficient = std::uniform_int_distribution<int64_t>(1, R);
+  auto error = std::uniform_int_distribution<int64_t>(-width, width);
+  std::vector<int64_t> points(k + n * (m + k));
+  std::vector<int64_t> cuts(m + 1);
   for (int i = 0; i < n; i++) {
-    int64_t weight = (std::rand() % (MAX - 1)) + 1;
+    int64_t *item = points.data() + k + i * (m + k);
+    int64_t mean = 0;
+    if (name == "inverse") {
+      mean = coefficient(rng);
+      item[m] = mean + offset + error(rng);
+    } else {
+      item[m] = coefficient(rng);
+      mean = item[m] + offset + error(rng);
+    }
+    item[m] = std::max<int64_t>(1, item[m]);
+    for (int c = 1; c < k; c++) {
+      item[m + c] = coefficient(rng);
+    }
+    // Each objective gets at least 1, the rest of the total is cut at m - 1 uniform points.
+    const int64_t spare = std::max<int64_t>(0, m * (mean - 1));
+    auto cut = std::uniform_int_distribution<int64_t>(0, spare);
+    cuts[0] = 0;
+    cuts[m] = spare;
+    for (int j = 1; j < m; j++) {
+      cuts[j] = cut(rng);
+    }
+    std::sort(cuts.begin() + 1, cuts.begin() + m);
     for (int j = 0; j < m; j++) {
-      int64_t num = (std::rand() % (MAX - 1)) + 1;
-      int32_t index = (i * (m + 1)) + j;
-      points[index] = num;
+      item[j] = 1 + cuts[j + 1] - cuts[j];
     }
-    points[(i * (m + 1)) + m] = weight;
-    total_weight += weight;
   }
-  int64_t W = std::round(total_weight * args.get_weight_factor());
-  points.insert(points.begin(), W);
+  for (int c = 0; c < k; c++) {
+    int64_t total_weight = 0;
+    for (int i = 0; i < n; i++) {
+      total_weight += points[k + i * (m + k) + m + c];
+    }
+    points[c] = std::round(total_weight * args.get_weight_factor());
+  }
+  return points;
+}
 
-  auto problem_solutions = solve_mobkp(args, points);
-  auto problem = problem_solutions.first;
-  auto solutions = problem_solutions.second;
+// Points of a random instance: the k capacities, then the m values and the k weights of each item.
+std::vector<data_type> generate_random_points(const Arguments &args, const int32_t MAX = 300) {
+  MOBKP_TRACE_SPAN("generate_random_points", "generate");
+  if (args.get_class() != "uncorrelated") {
+    return generate_class_points(args);
+  }
+  const int32_t n = args.get_n();
+  const int32_t m = args.get_m();
+  const int32_t k = args.get_k();
+  std::srand(args.get_seed());
 
-  write_solution(args.get_folder_path(), args.get_outfile(), problem, solutions);
+  std::vector<int64_t> points(n * (m + k));
+  std::vector<int64_t> total_weight(k, 0);
+  {
+    MOBKP_TRACE_SPAN("sample", "generate");
+    for (int i = 0; i < n; i++) {
+      // The first weight is drawn before the values, as for a single constraint.
+      int64_t weight = (std::rand() % (MAX - 1)) + 1;
+      for (int j = 0; j < m; j++) {
+        int64_t num = (std::rand() % (MAX - 1)) + 1;
+        int32_t index = (i * (m + k)) + j;
+        points[index] = num;
+      }
+      points[(i * (m + k)) + m] = weight;
+      total_weight[0] += weight;
+      for (int c = 1; c < k; c++) {
+        weight = (std::rand() % (MAX - 1)) + 1;
+        points[(i * (m + k)) + m + c] = weight;
+        total_weight[c] += weight;
+      }
+    }
+  }
+  for (int c = k - 1; c >= 0; c--) {
+    int64_t W = std::round(total_weight[c] * args.get_weight_factor());
+    points.insert(points.begin(), W);
+  }
+  return points;
 }
 
-void generate_corr_mobkp_test(const Arguments &args) {
+// Points of a correlated instance, sampled by the R generator or its native
+// version. The R generator writes to a temporary file private to this host,
+// process and thread, removed once read, so nothing is left at the instance
+// path when the instance is only estimated or its solve does not finish.
+std::vector<data_type> generate_corr_points(const Arguments &args) {
+  MOBKP_TRACE_SPAN("generate_corr_points", "generate");
+  if (args.get_sampler() == "native") {
+    MOBKP_TRACE_SPAN("sample_correlated_points", "generate");
+    return sample_correlated_points(args.get_n(), args.get_m(), args.get_correlation(), 0.0, args.get_weight_factor(),
+                                    args.get_seed());
+  }
   const int32_t n = args.get_n();
   const int32_t m = args.get_m();
   const double rho = args.get_correlation();
   const int64_t seed = args.get_seed();
   const double weight_factor = args.get_weight_factor();
-  const std::string file_path = args.get_folder_path() + "/" + args.get_outfile();
+  char host[256] = {};
+  ::gethostname(host, sizeof(host) - 1);
+  const std::string file_path = fmt::format("{}/{}.generator.{}.{}.{}.tmp", args.get_folder_path(), args.get_outfile(),
+                                            host, ::getpid(), std::hash<std::thread::id>{}(std::this_thread::get_id()));
   const std::string r_script_path = "../scripts/generator.R";
   const std::string rho_str = fmt::format("{:.2f}", rho);
 
   const std::string command = fmt::format("./{} {} {} {} {} {} {} {}", r_script_path, n, m, rho, 0, weight_factor, seed, file_path);
-  int result = system(command.c_str());
-  if (result != 0) {
-    throw std::runtime_error("Command execution failed with status: " + std::to_string(result));
+  {
+    MOBKP_TRACE_SPAN("generator.R", "generate");
+    int result = system(command.c_str());
+    if (result != 0) {
+      std::filesystem::remove(file_path);
+      throw std::runtime_error("Command execution failed with status: " + std::to_string(result));
+    }
   }
 
   auto fin = std::fstream(file_path, std::ios::in);
@@ -118,6 +580,7 @@ void generate_corr_mobkp_test(const Arguments &args) {
     fmt::print("Error: Could not open file {}\n", file_path);
     exit(1);
   }
+  std::filesystem::remove(file_path);  // the open stream still reads it
 
   int32_t _n, _m;
   fin >> _n >> _m;
@@ -136,12 +599,51 @@ void generate_corr_mobkp_test(const Arguments &args) {
     points[(i * (_m + 1)) + _m] = weight;
   }
   points.insert(points.begin(), W);
+  return points;
+}
 
-  auto problem_solutions = solve_mobkp(args, points);
-  auto problem = problem_solutions.first;
-  auto solutions = problem_solutions.second;
+// Points of a bounded instance: the coefficients of the random instance, with
+// each capacity set by the weight factor over the weights of all the copies.
+std::vector<data_type> generate_bounded_points(const Arguments &args) {
+  MOBKP_TRACE_SPAN("generate_bounded_points", "generate");
+  const int32_t m = args.get_m();
+  const int32_t k = args.get_k();
+  auto points = generate_random_points(args);
+  const auto multiplicities = generate_multiplicities(args);
+  for (int c = 0; c < k; c++) {
+    int64_t total_weight = 0;
+    for (size_t i = 0; i < multiplicities.size(); i++) {
+      total_weight += multiplicities[i] * points[k + i * (m + k) + m + c];
+    }
+    points[c] = std::round(total_weight * args.get_weight_factor());
+  }
+  return points;
+}
+
+std::vector<data_type> generate_points(const Arguments &args) {
+  switch (args.get_type()) {
+    case 0:
+      return generate_random_points(args);
+    case 3:
+      return generate_bounded_points(args);
+    default:
+      return generate_corr_points(args);
+  }
+}
+
+void generate_random_mobkp_test(const Arguments &args) {
+  MOBKP_TRACE_SPAN("generate_random_mobkp_test", "generate");
+  solve_and_write(args, generate_random_points(args));
+}
+
+void generate_corr_mobkp_test(const Arguments &args) {
+  MOBKP_TRACE_SPAN("generate_corr_mobkp_test", "generate");
+  solve_and_write(args, generate_corr_points(args));
+}
 
-  write_solution(args.get_folder_path(), args.get_outfile(), problem, solutions);
+void generate_bounded_mobkp_test(const Arguments &args) {
+  MOBKP_TRACE_SPAN("generate_bounded_mobkp_test", "generate");
+  solve_and_write(args, generate_bounded_points(args));
 }
 
 #endif  // SOLVER_HPP
@@ -0,0 +1,57 @@
+#ifndef STATE_HPP
+#define STATE_HPP
+
+#include <cstddef>
+
+// Layout helpers for a state record: m objective values followed by k weights.
+template <typename T>
+struct state_layout {
+  size_t m;
+  size_t k;
+
+  size_t width() const { return m + k; }
+
+  T weight_sum(const T *s) const {
+    T sum = 0;
+    for (size_t j = 0; j < k; ++j) {
+      sum += s[m + j];
+    }
+    return sum;
+  }
+
+  // Strict order in which a dominating state always precedes the states it dominates.
+  bool before(const T *a, const T *b) const {
+    T wa = weight_sum(a), wb = weight_sum(b);
+    if (wa != wb) {
+      return wa < wb;
+    }
+    for (size_t j = m; j < m + k; ++j) {
+      if (a[j] != b[j]) {
+        return a[j] < b[j];
+      }
+    }
+    for (size_t j = 0; j < m; ++j) {
+      if (a[j] != b[j]) {
+        return a[j] > b[j];
+      }
+    }
+    return false;
+  }
+
+  // a dominates (or is equal to) b: no less value and no more weight.
+  bool dominates(const T *a, const T *b) const {
+    for (size_t j = 0; j < m; ++j) {
+      if (a[j] < b[j]) {
+        return false;
+      }
+    }
+    for (size_t j = m; j < m + k; ++j) {
+      if (a[j] > b[j]) {
+        return false;
+      }
+    }
+    return true;
+  }
+};
+
+#endif  // STATE_HPP
@@ -0,0 +1,129 @@
+#ifndef STATS_HPP
+#define STATS_HPP
+
+#include <fmt/core.h>
+#include <fmt/ostream.h>
+
+#include <chrono>
+#include <filesystem>
+#include <fstream>
+#include <stdexcept>
+#include <string>
+#include <vector>
+
+#include <pages.hpp>
+
+// Statistics policies of the native DP engines. The engines call the hooks
+// below for every layer, candidate and dominance test; with `no_stats` they
+// are empty inline functions and the counters are compiled out.
+
+struct no_stats {
+  static constexpr bool enabled = false;
+
+  void begin_layer(size_t, size_t) {}
+  void candidate() {}
+  void capacity_rejection() {}
+  void capacity_rejections(size_t) {}
+  void dominance_test() {}
+  void dominance_tests(size_t) {}
+  void bound_rejections(size_t) {}
+  void end_layer(size_t, size_t) {}
+};
+
+struct layer_record {
+  size_t item = 0;
+  size_t states_before = 0;
+  size_t candidates = 0;
+  size_t capacity_rejections = 0;
+  size_t dominance_tests = 0;
+  size_t bound_rejections = 0;  // states dropped by the presolve bounds
+  size_t states_after = 0;
+  size_t bytes = 0;
+  double time = 0.0;
+  int64_t page_faults = 0;   // of the solving thread
+  int64_t dtlb_misses = -1;  // -1 when perf events are not available
+  double map_time = 0.0;     // mapping and prefaulting state arenas
+};
+
+struct layer_stats {
+  static constexpr bool enabled = true;
+
+  std::vector<layer_record> layers;
+
+  void begin_layer(size_t item, size_t states) {
+    current = layer_record{};
+    current.item = item;
+    current.states_before = states;
+    faults_start = thread_page_faults();
+    tlb_start = tlb.read();
+    map_ns_start = thread_map_ns();
+    start = std::chrono::steady_clock::now();
+  }
+  void candidate() { ++current.candidates; }
+  void capacity_rejection() { ++current.capacity_rejections; }
+  void capacity_rejections(size_t count) { current.capacity_rejections += count; }
+  void dominance_test() { ++current.dominance_tests; }
+  void dominance_tests(size_t count) { current.dominance_tests += count; }
+  void bound_rejections(size_t count) { current.bound_rejections += count; }
+  void end_layer(size_t states, size_t bytes) {
+    current.states_after = states;
+    current.bytes = bytes;
+    current.time = std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count();
+    current.page_faults = thread_page_faults() - faults_start;
+    const int64_t tlb_end = tlb.read();
+    current.dtlb_misses = tlb_start < 0 || tlb_end < 0 ? -1 : tlb_end - tlb_start;
+    current.map_time = (thread_map_ns() - map_ns_start) / 1e9;
+    layers.push_back(current);
+  }
+
+ private:
+  layer_record current;
+  std::chrono::steady_clock::time_point start;
+  tlb_counter tlb;
+  int64_t faults_start = 0;
+  int64_t tlb_start = -1;
+  int64_t map_ns_start = 0;
+};
+
+// Writes the per-layer report as "json" or "csv".
+void write_stats(const std::string &file_path, const std::string &format, const std::string &engine,
+                 const layer_stats &stats, size_t front_size) {
+  const auto parent = std::filesystem::path(file_path).parent_path();
+  if (!parent.empty() && !std::filesystem::exists(parent)) {
+    std::filesystem::create_directories(parent);
+  }
+  auto out = std::ofstream(file_path);
+  if (!out.is_open()) {
+    throw std::runtime_error("Could not open file " + file_path);
+  }
+  if (format == "csv") {
+    fmt::print(out, "item,states_before,candidates,capacity_rejections,dominance_tests,bound_rejections,states_after,"
+               "bytes,time,page_faults,dtlb_misses,map_time\n");
+    for (auto const &l : stats.layers) {
+      fmt::print(out, "{},{},{},{},{},{},{},{},{},{},{},{}\n", l.item, l.states_before, l.candidates,
+                 l.capacity_rejections, l.dominance_tests, l.bound_rejections, l.states_after, l.bytes, l.time,
+                 l.page_faults, l.dtlb_misses, l.map_time);
+    }
+    return;
+  }
+  auto const &pages = global_page_counters();
+  fmt::print(out, "{{\n  \"engine\": \"{}\",\n  \"front_size\": {},\n", engine, front_size);
+  fmt::print(out,
+             "  \"pages\": {{\"mapped_bytes\": {}, \"hugetlb_bytes\": {}, \"anon_huge_bytes\": {}, \"map_time\": {}, "
+             "\"prefault_time\": {}}},\n",
+             pages.mapped_bytes.load(), pages.hugetlb_bytes.load(), anon_huge_bytes(), pages.map_ns.load() / 1e9,
+             pages.prefault_ns.load() / 1e9);
+  fmt::print(out, "  \"layers\": [");
+  for (size_t i = 0; i < stats.layers.size(); ++i) {
+    auto const &l = stats.layers[i];
+    fmt::print(out,
+               "{}\n    {{\"item\": {}, \"states_before\": {}, \"candidates\": {}, \"capacity_rejections\": {}, "
+               "\"dominance_tests\": {}, \"bound_rejections\": {}, \"states_after\": {}, \"bytes\": {}, \"time\": {}, "
+               "\"page_faults\": {}, \"dtlb_misses\": {}, \"map_time\": {}}}",
+               i == 0 ? "" : ",", l.item, l.states_before, l.candidates, l.capacity_rejections, l.dominance_tests,
+               l.bound_rejections, l.states_after, l.bytes, l.time, l.page_faults, l.dtlb_misses, l.map_time);
+  }
+  fmt::print(out, "\n  ]\n}}\n");
+}
+
+#endif  // STATS_HPP
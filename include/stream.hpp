@@ -0,0 +1,190 @@
+#ifndef STREAM_HPP
+#define STREAM_HPP
+
+#include <fmt/core.h>
+#include <fmt/ostream.h>
+#include <fmt/ranges.h>
+
+#include <algorithm>
+#include <cmath>
+#include <cstdint>
+#include <fstream>
+#include <functional>
+#include <limits>
+#include <numeric>
+#include <set>
+#include <stdexcept>
+#include <string>
+#include <vector>
+
+#include <pages.hpp>
+
+// Points of the front that are final before the solve ends.
+//
+// After the layer of item i, every solution of the instance is (weakly)
+// dominated by a state of the layer plus some of the remaining items. A state
+// s whose slack is below the lightest remaining item in some constraint can
+// take no further item, so its values p are a solution of the instance; p is
+// in the final front when no other state can reach it, i.e. no state t has
+// t + U(t) >= p, where U(t) bounds the values the remaining items add within
+// the slack of t: the smallest of their sum and, per constraint, the largest
+// value to weight ratio times the slack.
+
+template <typename T>
+class final_point_tracker {
+ public:
+  template <typename Problem>
+  explicit final_point_tracker(const Problem &problem)
+      : n(problem.num_items()), m(problem.num_objectives()), k(problem.num_constraints()), capacity(k) {
+    for (size_t c = 0; c < k; ++c) {
+      capacity[c] = problem.weight_capacity(c);
+    }
+    // Suffix minima of the weights, sums of the values and maxima of the ratios.
+    min_weight.assign((n + 1) * k, std::numeric_limits<T>::max());
+    value_sum.assign((n + 1) * m, 0);
+    ratio.assign((n + 1) * m * k, 0.0);
+    for (size_t i = n; i-- > 0;) {
+      auto values = problem.item_values(i);
+      auto weights = problem.item_weights(i);
+      for (size_t c = 0; c < k; ++c) {
+        min_weight[i * k + c] = std::min<T>(min_weight[(i + 1) * k + c], weights[c]);
+      }
+      for (size_t j = 0; j < m; ++j) {
+        value_sum[i * m + j] = value_sum[(i + 1) * m + j] + values[j];
+        for (size_t c = 0; c < k; ++c) {
+          const double r = weights[c] > 0 ? static_cast<double>(values[j]) / weights[c]
+                                           : std::numeric_limits<double>::infinity();
+          ratio[(i * m + j) * k + c] = std::max(ratio[((i + 1) * m + j) * k + c], r);
+        }
+      }
+    }
+  }
+
+  // Points that became final with the layer of the first `done` items.
+  std::vector<std::vector<T>> update(size_t done, const state_vector<T> &layer) {
+    const size_t width = m + k;
+    const size_t states = layer.size() / width;
+    std::vector<T> reach(states * m);
+    std::vector<uint8_t> closed(states);
+    for (size_t s = 0; s < states; ++s) {
+      const T *state = layer.data() + s * width;
+      closed[s] = done == n;
+      for (size_t c = 0; c < k && !closed[s]; ++c) {
+        closed[s] = capacity[c] - state[m + c] < min_weight[done * k + c];
+      }
+      for (size_t j = 0; j < m; ++j) {
+        T gain = 0;
+        if (!closed[s]) {
+          double bound = static_cast<double>(value_sum[done * m + j]);
+          for (size_t c = 0; c < k; ++c) {
+            bound = std::min(bound, std::floor(ratio[(done * m + j) * k + c] * (capacity[c] - state[m + c])));
+          }
+          gain = static_cast<T>(bound);
+        }
+        reach[s * m + j] = state[j] + gain;
+      }
+    }
+    // The states most likely to reach a point come first.
+    std::vector<size_t> order(states);
+    std::iota(order.begin(), order.end(), 0);
+    std::sort(order.begin(), order.end(), [&](size_t a, size_t b) { return reach[a * m] > reach[b * m]; });
+
+    std::vector<std::vector<T>> points;
+    for (size_t s = 0; s < states; ++s) {
+      if (!closed[s]) {
+        continue;
+      }
+      const T *p = layer.data() + s * width;
+      auto point = std::vector<T>(p, p + m);
+      if (emitted.count(point) > 0) {
+        continue;
+      }
+      bool reached = false;
+      for (size_t r = 0; r < states && !reached && reach[order[r] * m] >= p[0]; ++r) {
+        const size_t t = order[r];
+        if (t == s) {
+          continue;
+        }
+        reached = true;
+        for (size_t j = 1; j < m && reached; ++j) {
+          reached = reach[t * m + j] >= p[j];
+        }
+      }
+      if (!reached) {
+        emitted.insert(point);
+        points.push_back(std::move(point));
+      }
+    }
+    return points;
+  }
+
+  // The points of the final front not yet reported.
+  std::vector<std::vector<T>> remaining(const std::vector<std::vector<T>> &front) const {
+    std::vector<std::vector<T>> points;
+    for (auto const &p : front) {
+      if (emitted.count(p) == 0) {
+        points.push_back(p);
+      }
+    }
+    return points;
+  }
+
+ private:
+  size_t n, m, k;
+  std::vector<T> capacity;
+  std::vector<T> min_weight;
+  std::vector<T> value_sum;
+  std::vector<double> ratio;
+  std::set<std::vector<T>> emitted;
+};
+
+// Writes the final points of a solve to a file as they are reported. Every
+// line that does not start with '#' is a point of the final front; the
+// comment lines separate the points by the layer that made them final. A
+// solve that times out ends the file with the front of its last layer under a
+// "# timed out" line instead, and those points are not final.
+class front_stream {
+ public:
+  front_stream(const std::string &path, size_t n, size_t m) : out(path) {
+    if (!out.is_open()) {
+      throw std::runtime_error("Could not open file " + path);
+    }
+    fmt::print(out, "# final points of the front of n={} m={}, the rest follow when the solve ends\n", n, m);
+    out.flush();
+  }
+
+  template <typename T>
+  void write(size_t done, const std::vector<std::vector<T>> &points) {
+    fmt::print(out, "# final after item {}: {} points\n", done, points.size());
+    for (auto const &p : points) {
+      fmt::print(out, "{:d}\n", fmt::join(p, " "));
+    }
+    total += points.size();
+    out.flush();
+  }
+
+  template <typename T>
+  void finish(const std::vector<std::vector<T>> &points, bool timed_out = false) {
+    if (timed_out) {
+      fmt::print(out, "# timed out, not final: {} points\n", points.size());
+      for (auto const &p : points) {
+        fmt::print(out, "{:d}\n", fmt::join(p, " "));
+      }
+      out.flush();
+      return;
+    }
+    fmt::print(out, "# final at the end of the solve: {} points\n", points.size());
+    for (auto const &p : points) {
+      fmt::print(out, "{:d}\n", fmt::join(p, " "));
+    }
+    total += points.size();
+    fmt::print(out, "# complete: {} points\n", total);
+    out.flush();
+  }
+
+ private:
+  std::ofstream out;
+  size_t total = 0;
+};
+
+#endif  // STREAM_HPP
@@ -0,0 +1,125 @@
+#ifndef SWEEP_HPP
+#define SWEEP_HPP
+
+#include <fmt/core.h>
+
+#include <algorithm>
+#include <memory>
+#include <stdexcept>
+#include <string>
+#include <vector>
+
+#include <layered_dp.hpp>
+#include <many_dp.hpp>
+#include <pages.hpp>
+#include <parser.hpp>
+#include <solver.hpp>
+
+// Fronts of every n-prefix of one instance from a single DP pass.
+//
+// The random generators draw the items one after the other, so the instance
+// of n items with a given seed is the first n items of any larger one, with
+// the capacity set by the weight factor over the prefix weight. That capacity
+// is at most the capacity of the largest instance, and a state dropped from a
+// layer is dominated by a kept state of no more weight, so the front of the
+// prefix of i items is the front of the states of layer i that fit within the
+// prefix capacity. The DP runs once over the largest instance and writes each
+// prefix instance when its layer is reached.
+
+class size_sweep {
+ public:
+  explicit size_sweep(const Arguments &args)
+      : base(args.with_option("--seed", std::to_string(args.get_seed()))), sizes(args.get_n_sweep()) {}
+
+  void run() {
+    const auto largest = prefix_arguments(sizes.back());
+    const auto multiplicities = generate_multiplicities(*largest);
+    auto points = generate_points(*largest);
+    const int32_t m = largest->get_m();
+    const int32_t k = largest->get_k();
+    if (!multiplicities.empty()) {
+      points = split_bounded(m, k, points, multiplicities);
+    }
+    const int32_t items = static_cast<int32_t>((points.size() - k) / (m + k));
+
+    // The layer after which each prefix instance is complete, with its capacities.
+    for (auto n : sizes) {
+      auto prefix = pending_prefix{};
+      prefix.args = prefix_arguments(n);
+      prefix.points = generate_points(*prefix.args);
+      prefix.multiplicities = generate_multiplicities(*prefix.args);
+      auto split = prefix.multiplicities.empty() ? prefix.points : split_bounded(m, k, prefix.points, prefix.multiplicities);
+      if (!std::equal(split.begin() + k, split.end(), points.begin() + k)) {
+        throw std::runtime_error(fmt::format("The instance of n={} is not a prefix of the instance of n={}.", n, sizes.back()));
+      }
+      prefix.items = (split.size() - k) / (m + k);
+      prefix.capacity.assign(split.begin(), split.begin() + k);
+      prefixes.push_back(std::move(prefix));
+    }
+
+    const auto problem = mobkp::problem<data_type>(items, m, k, std::move(points));
+    const auto pages = scoped_page_policy(page_policy{parse_page_mode(base->get_huge_pages()), base->get_prefault()});
+    auto observe = [&](size_t done, const state_vector<data_type> &layer) {
+      for (auto &prefix : prefixes) {
+        if (prefix.items == done) {
+          write_prefix(prefix, layer, m, k);
+        }
+      }
+    };
+    auto stats = no_stats{};
+    auto hooks = dp_hooks<data_type>{};
+    hooks.observe = observe;
+    if (base->get_algorithm() == "many") {
+      many_dp<data_type>(problem, base->get_timeout(), base->get_threads(), stats, std::move(hooks));
+    } else {
+      layered_dp<data_type>(problem, base->get_timeout(), stats, std::move(hooks));
+    }
+    for (auto const &prefix : prefixes) {
+      if (!prefix.written) {
+        fmt::print("[sweep] n={} not reached before the timeout\n", prefix.args->get_n());
+      }
+    }
+  }
+
+ private:
+  struct pending_prefix {
+    std::unique_ptr<Arguments> args;
+    std::vector<data_type> points;
+    std::vector<int64_t> multiplicities;
+    size_t items = 0;  // DP items of the prefix, after splitting
+    std::vector<data_type> capacity;
+    bool written = false;
+  };
+
+  std::unique_ptr<Arguments> base;
+  std::vector<int32_t> sizes;
+  std::vector<pending_prefix> prefixes;
+
+  std::unique_ptr<Arguments> prefix_arguments(int32_t n) const {
+    return base->with_options({{"--n-sweep", ""}, {"--n", std::to_string(n)}});
+  }
+
+  void write_prefix(pending_prefix &prefix, const state_vector<data_type> &layer, size_t m, size_t k) {
+    MOBKP_TRACE_SPAN("prefix", "io");
+    const size_t width = m + k;
+    state_vector<data_type> fitting;
+    for (size_t s = 0; s < layer.size(); s += width) {
+      const data_type *state = layer.data() + s;
+      bool fits = true;
+      for (size_t c = 0; c < k; ++c) {
+        fits &= state[m + c] <= prefix.capacity[c];
+      }
+      if (fits) {
+        fitting.insert(fitting.end(), state, state + width);
+      }
+    }
+    const auto front = front_of_states(fitting, m, width);
+    const auto &args = *prefix.args;
+    const auto problem = mobkp::problem<data_type>(args.get_n(), args.get_m(), args.get_k(), std::move(prefix.points));
+    write_solution(args.get_folder_path(), args.get_outfile(), problem, front, prefix.multiplicities);
+    prefix.written = true;
+    fmt::print("[sweep] {}{}: front of {} points\n", args.get_folder_path(), args.get_outfile(), front.size());
+  }
+};
+
+#endif  // SWEEP_HPP
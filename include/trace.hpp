@@ -0,0 +1,161 @@
+#ifndef TRACE_HPP
+#define TRACE_HPP
+
+#include <string>
+
+// Scoped-span tracing of the generation pipeline, dumped in the Chrome Trace
+// Event format (chrome://tracing, ui.perfetto.dev).
+//
+// Spans are only compiled in when MOBKP_TRACE is defined (cmake -DMOBKP_TRACE=ON);
+// otherwise MOBKP_TRACE_SPAN expands to nothing. When compiled in, spans are
+// recorded only after trace_enable(), each thread writing to its own ring
+// buffer that keeps the most recent events, so no lock is taken per span.
+
+#ifdef MOBKP_TRACE
+
+#include <unistd.h>
+
+#include <fmt/core.h>
+#include <fmt/ostream.h>
+
+#include <algorithm>
+#include <atomic>
+#include <chrono>
+#include <fstream>
+#include <memory>
+#include <mutex>
+#include <stdexcept>
+#include <vector>
+
+struct trace_event {
+  const char *name;
+  const char *category;
+  int64_t start_ns;
+  int64_t duration_ns;
+};
+
+class trace_ring {
+ public:
+  static constexpr size_t capacity = size_t(1) << 16;
+
+  explicit trace_ring(size_t tid) : tid(tid), events(capacity) {}
+
+  void push(const trace_event &event) {
+    events[written % capacity] = event;
+    ++written;
+  }
+
+  size_t thread_id() const { return tid; }
+  size_t size() const { return std::min(written, capacity); }
+  size_t dropped() const { return written - size(); }
+  const trace_event &operator[](size_t i) const { return events[(written - size() + i) % capacity]; }
+
+ private:
+  size_t tid;
+  std::vector<trace_event> events;
+  size_t written = 0;
+};
+
+class trace_registry {
+ public:
+  static trace_registry &instance() {
+    static trace_registry registry;
+    return registry;
+  }
+
+  void enable() {
+    origin = std::chrono::steady_clock::now();
+    enabled.store(true, std::memory_order_release);
+  }
+  bool is_enabled() const { return enabled.load(std::memory_order_relaxed); }
+
+  int64_t now_ns() const {
+    return std::chrono::duration_cast<std::chrono::nanoseconds>(std::chrono::steady_clock::now() - origin).count();
+  }
+
+  // Ring of the calling thread, registered on first use.
+  trace_ring &local_ring() {
+    thread_local std::shared_ptr<trace_ring> ring;
+    if (!ring) {
+      std::lock_guard<std::mutex> lock(mutex);
+      ring = std::make_shared<trace_ring>(rings.size());
+      rings.push_back(ring);
+    }
+    return *ring;
+  }
+
+  // Writes the events of every thread; call it once the traced work is done.
+  void dump(const std::string &file_path) {
+    std::lock_guard<std::mutex> lock(mutex);
+    auto out = std::ofstream(file_path);
+    if (!out.is_open()) {
+      throw std::runtime_error("Could not open file " + file_path);
+    }
+    const auto pid = ::getpid();
+    bool first = true;
+    size_t dropped = 0;
+    fmt::print(out, "{{\"traceEvents\": [");
+    for (auto const &ring : rings) {
+      dropped += ring->dropped();
+      for (size_t i = 0; i < ring->size(); ++i) {
+        auto const &e = (*ring)[i];
+        fmt::print(out, "{}\n  {{\"name\": \"{}\", \"cat\": \"{}\", \"ph\": \"X\", \"ts\": {:.3f}, \"dur\": {:.3f}, "
+                   "\"pid\": {}, \"tid\": {}}}",
+                   first ? "" : ",", e.name, e.category, e.start_ns / 1e3, e.duration_ns / 1e3, pid,
+                   ring->thread_id());
+        first = false;
+      }
+    }
+    fmt::print(out, "\n], \"displayTimeUnit\": \"ms\", \"otherData\": {{\"dropped_events\": {}}}}}\n", dropped);
+  }
+
+ private:
+  std::atomic<bool> enabled = false;
+  std::chrono::steady_clock::time_point origin = std::chrono::steady_clock::now();
+  std::mutex mutex;
+  std::vector<std::shared_ptr<trace_ring>> rings;
+};
+
+class trace_span {
+ public:
+  trace_span(const char *name, const char *category) : name(name), category(category) {
+    auto &registry = trace_registry::instance();
+    active = registry.is_enabled();
+    if (active) {
+      start_ns = registry.now_ns();
+    }
+  }
+  ~trace_span() {
+    if (active) {
+      auto &registry = trace_registry::instance();
+      const int64_t end_ns = registry.now_ns();
+      registry.local_ring().push({name, category, start_ns, end_ns - start_ns});
+    }
+  }
+  trace_span(const trace_span &) = delete;
+  trace_span &operator=(const trace_span &) = delete;
+
+ private:
+  const char *name;
+  const char *category;
+  int64_t start_ns = 0;
+  bool active;
+};
+
+#define MOBKP_TRACE_CONCAT_IMPL(a, b) a##b
+#define MOBKP_TRACE_CONCAT(a, b) MOBKP_TRACE_CONCAT_IMPL(a, b)
+#define MOBKP_TRACE_SPAN(name, category) trace_span MOBKP_TRACE_CONCAT(trace_span_, __LINE__)(name, category)
+
+inline void trace_enable() { trace_registry::instance().enable(); }
+inline void trace_dump(const std::string &file_path) { trace_registry::instance().dump(file_path); }
+
+#else
+
+#define MOBKP_TRACE_SPAN(name, category)
+
+inline void trace_enable() {}
+inline void trace_dump(const std::string &) {}
+
+#endif  // MOBKP_TRACE
+
+#endif  // TRACE_HPP
@@ -0,0 +1,25 @@
+#!/usr/bin/env bash
+
+# Writes the job list of a shard directory, to be run by any number of
+# workers: ./../build/mobkp-instances --shard-dir=<dir>
+
+trap "exit" INT
+
+shard_dir=${1:?usage: gen_shard_jobs.sh <shard-dir>}
+mkdir -p $shard_dir
+
+weight_factor=0.5
+ns=(50 100 200 300 400 500 600 700 800 900 1000 1500 2000)
+seeds=(1 2 3 4 5 6 7 8 9 10)
+pos_correlations=(0.25 0.5 0.8)
+
+{
+  for n in ${ns[@]}; do
+    for s in ${seeds[@]}; do
+      echo "--type=0 --n=$n --m=2 --seed=$s --weight-factor=$weight_factor"
+      for c in ${pos_correlations[@]}; do
+        echo "--type=2 --n=$n --m=2 --seed=$s --weight-factor=$weight_factor --correlation=$c"
+      done
+    done
+  done
+} > $shard_dir/jobs.txt